@@ -0,0 +1,189 @@
+#ifndef DCI_BINARYBUFFER_H_INCLUDED
+#define DCI_BINARYBUFFER_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ColumnData.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// Description: Binary Buffer Writer Class.
+//
+// Serializes primitive values, strings, values and vectors by
+// appending them to a memory buffer, e.g. in order to write them to a
+// file in one piece. The data can be read with BinaryReader, also from
+// a file mapped into memory. Numbers are stored in the byte order of
+// the machine.
+class BinaryWriter {
+public:
+	BinaryWriter(std::vector<char> &buffer) : m_Buffer(buffer) {}
+
+	// Description:
+	// Appends raw bytes, a number, a string, a value or a vector of
+	// byte, integer, double, string or value elements.
+	void Put(const void *p, size_t Len) {
+		m_Buffer.insert(m_Buffer.end(), (const char *)p, (const char *)p + Len);
+	}
+	void Put(Byte b)               { Put(&b, sizeof(b)); }
+	void Put(Int i)                { Put(&i, sizeof(i)); }
+	void Put(UInt u)               { Put(&u, sizeof(u)); }
+	void Put(unsigned long long u) { Put(&u, sizeof(u)); }
+	void Put(Double d)             { Put(&d, sizeof(d)); }
+	void Put(const String &s) {
+		Put((unsigned long long)s.Len());
+		Put((const char *)s, s.Len());
+	}
+	void Put(const Value &v) {
+		Put((Int)v.GetDataType());
+		switch (v.GetDataType()) {
+			case DT_BYTE:   Put(v.operator Byte()); break;
+			case DT_INT:    Put(v.operator Int()); break;
+			case DT_DOUBLE: Put(v.operator Double()); break;
+			case DT_STRING: Put(v.operator String()); break;
+			default:        break;
+		}
+	}
+	void Put(const Vector &v) {
+		size_t Len = v.Len();
+		Put((Int)(Len ? v.GetDataType() : DT_VOID));
+		Put((unsigned long long)Len);
+		if (!Len) return;
+		switch (v.GetDataType()) {
+			case DT_BYTE:   Put(ColumnData::GetPtr<Byte>(v), Len * sizeof(Byte)); break;
+			case DT_INT:    Put(ColumnData::GetPtr<Int>(v), Len * sizeof(Int)); break;
+			case DT_DOUBLE: Put(ColumnData::GetPtr<Double>(v), Len * sizeof(Double)); break;
+			case DT_STRING: for (size_t i=0; i<Len; i++) Put(StringVector(v).GetPtr()[i]); break;
+			case DT_VALUE:  for (size_t i=0; i<Len; i++) Put(ValueVector(v).GetPtr()[i]); break;
+			default:        break;
+		}
+	}
+
+	// Description:
+	// Returns the number of bytes in the buffer.
+	size_t GetSize() const {
+		return m_Buffer.size();
+	}
+
+private:
+	BinaryWriter &operator = (const BinaryWriter &);
+
+	std::vector<char> &m_Buffer;
+};
+
+// {internal}
+// Description: Binary Buffer Reader Class.
+//
+// Deserializes data written by BinaryWriter from a memory range. Every
+// read is checked against the end of the range, so that corrupt data
+// makes the read fail instead of reading beyond the range.
+class BinaryReader {
+public:
+	BinaryReader(const char *p, size_t Len) : m_p(p), m_pEnd(p + Len) {}
+
+	// Description:
+	// Reads raw bytes, a number, a string, a value or a vector (see
+	// BinaryWriter::Put).
+	//
+	// Returns:
+	// true if the data was read, or false if the range is exhausted or
+	// the data is corrupt.
+	Bool Get(void *p, size_t Len) {
+		if (GetRemaining() < Len) return false;
+		memcpy(p, m_p, Len);
+		m_p += Len;
+		return true;
+	}
+	Bool Get(Byte &b)               { return Get(&b, sizeof(b)); }
+	Bool Get(Int &i)                { return Get(&i, sizeof(i)); }
+	Bool Get(UInt &u)               { return Get(&u, sizeof(u)); }
+	Bool Get(unsigned long long &u) { return Get(&u, sizeof(u)); }
+	Bool Get(Double &d)             { return Get(&d, sizeof(d)); }
+	Bool Get(String &s) {
+		unsigned long long Len;
+		if (!Get(Len) || GetRemaining() < Len) return false;
+		s = String(m_p, (size_t)Len);
+		m_p += Len;
+		return true;
+	}
+	Bool Get(Value &v) {
+		Int type;
+		if (!Get(type)) return false;
+		switch (type) {
+			case DT_VOID:   v = Value(); return true;
+			case DT_BYTE:   { Byte b;   if (!Get(b)) return false; v = Value(b); return true; }
+			case DT_INT:    { Int i;    if (!Get(i)) return false; v = Value(i); return true; }
+			case DT_DOUBLE: { Double d; if (!Get(d)) return false; v = Value(d); return true; }
+			case DT_STRING: { String s; if (!Get(s)) return false; v = Value(s); return true; }
+			default:        return false;
+		}
+	}
+	Bool Get(Vector &v) {
+		Int type;
+		unsigned long long Len;
+		if (!Get(type) || !Get(Len) || Len > GetRemaining()) return false;
+		switch (Len ? type : DT_VOID) {
+			case DT_VOID:   v = Vector(); return true;
+			case DT_BYTE:   return GetFixed<Byte>(v, (size_t)Len);
+			case DT_INT:    return GetFixed<Int>(v, (size_t)Len);
+			case DT_DOUBLE: return GetFixed<Double>(v, (size_t)Len);
+			case DT_STRING: { StringVector sv; if (!GetComplex(sv, (size_t)Len)) return false; v = sv; return true; }
+			case DT_VALUE:  { ValueVector vv; if (!GetComplex(vv, (size_t)Len)) return false; v = vv; return true; }
+			default:        return false;
+		}
+	}
+
+	// Description:
+	// Returns a pointer to the data not read yet.
+	const char *GetPtr() const {
+		return m_p;
+	}
+
+	// Description:
+	// Returns the number of bytes not read yet.
+	size_t GetRemaining() const {
+		return m_pEnd - m_p;
+	}
+
+	// Description:
+	// Returns the number of bytes of a file not read yet, e.g. in order
+	// to check a size read from the file before allocating memory.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	static unsigned long long GetRemaining(FILE *fp) {
+		long long pos = _ftelli64(fp);
+		if (pos < 0 || _fseeki64(fp, 0, SEEK_END)) return 0;
+		long long end = _ftelli64(fp);
+		if (_fseeki64(fp, pos, SEEK_SET)) return 0;
+		return end > pos ? (unsigned long long)(end - pos) : 0;
+	}
+
+private:
+	template<class T> Bool GetFixed(Vector &v, size_t Len) {
+		if (GetRemaining() / sizeof(T) < Len) return false;
+		typename ColumnType<T>::VectorType tv;
+		T *p = ColumnData::Alloc<T>(tv, Len);
+		if (!p || !Get(p, Len * sizeof(T))) return false;
+		v = tv;
+		return true;
+	}
+
+	template<class V> Bool GetComplex(V &tv, size_t Len) {
+		if (!tv.ReDim(Len)) return false;
+		for (size_t i=0; i<Len; i++) {
+			if (!Get(tv[i])) return false;
+		}
+		return true;
+	}
+
+	const char *m_p;    // next byte to be read
+	const char *m_pEnd; // end of the range
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_BINARYBUFFER_H_INCLUDED */
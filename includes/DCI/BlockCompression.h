@@ -0,0 +1,424 @@
+#ifndef DCI_BLOCKCOMPRESSION_H_INCLUDED
+#define DCI_BLOCKCOMPRESSION_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/BinaryBuffer.h"
+#include "DCI/Parallel.h"
+
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// Description: Compression Codecs.
+//
+// The codecs of block compression (see BlockCompression). The filters
+// operate on elements of a fixed width (e.g. 8 bytes for doubles)
+// before the filtered bytes are LZ compressed:
+//
+// CC_SHUFFLE_LZ     - Byte shuffle: the first bytes of all elements are
+//                     stored first, then the second bytes and so on, so
+//                     that bytes of similar significance are adjacent.
+// CC_XOR_SHUFFLE_LZ - Every element is XORed with its predecessor
+//                     before the bytes are shuffled. For smooth series
+//                     (e.g. simulation results), the sign, exponent and
+//                     leading mantissa bits cancel out, yielding long
+//                     runs of zero bytes.
+enum CompressionCodec {
+	CC_NONE           = 0, // not compressed
+	CC_LZ             = 1, // LZ compressed
+	CC_SHUFFLE_LZ     = 2, // byte shuffled, then LZ compressed
+	CC_XOR_SHUFFLE_LZ = 3  // XORed with the preceding element, byte shuffled, then LZ compressed
+};
+
+// {internal}
+// {group:Global Modules}
+// Description: Block Compression Module.
+//
+// Routines compressing a buffer (e.g. the payload of a column in a
+// table file) with a fast byte-oriented LZ77 codec, optionally after a
+// filter (see CompressionCodec). The buffer is split into blocks of
+// BlockSize bytes that are compressed independently, so that they can
+// be compressed and decompressed in parallel; blocks that do not
+// shrink are stored uncompressed.
+//
+// A compressed buffer consists of the block size (UInt), the number of
+// blocks (UInt), the size of the uncompressed buffer (unsigned long
+// long), the end offset of every compressed block relative to the
+// first block (unsigned long long), the checksum of every uncompressed
+// block (unsigned long long) and the compressed blocks. The checksums
+// detect corrupt blocks that still decompress to the expected size.
+class BlockCompression {
+public:
+	enum {
+		BlockSize = 1 << 20 // size of the uncompressed blocks in bytes
+	};
+
+	// Description:
+	// Chooses the codec compressing a buffer best, by compressing its
+	// first block with every codec.
+	//
+	// Arguments:
+	// p     - The buffer.
+	// Len   - The size of the buffer in bytes.
+	// Width - The width of the elements of the buffer in bytes (1 for
+	//         unstructured data, which disables the filters).
+	//
+	// Returns:
+	// The codec, or CC_NONE if no codec shrinks the first block.
+	static CompressionCodec ChooseCodec(const char *p, size_t Len, size_t Width) {
+		size_t sampleLen = Len < (size_t)BlockSize ? Len : (size_t)BlockSize;
+		std::vector<unsigned char> out, scratch;
+		CompressionCodec bestCodec = CC_NONE;
+		size_t bestLen = sampleLen;
+		for (Int codec=CC_LZ; codec<=CC_XOR_SHUFFLE_LZ; codec++) {
+			if (codec != CC_LZ && Width <= 1) break;
+			size_t n = CompressBlock((const unsigned char *)p, sampleLen, Width, (CompressionCodec)codec, out, scratch);
+			if (n < bestLen) {
+				bestLen = n;
+				bestCodec = (CompressionCodec)codec;
+			}
+		}
+		return bestCodec;
+	}
+
+	// Description:
+	// Compresses a buffer. The blocks are compressed in parallel.
+	//
+	// Arguments:
+	// p     - The buffer.
+	// Len   - The size of the buffer in bytes.
+	// Width - The width of the elements of the buffer in bytes.
+	// codec - The codec (see ChooseCodec).
+	// out   - Buffer the compressed buffer is appended to.
+	static void Compress(const char *p, size_t Len, size_t Width, CompressionCodec codec, std::vector<char> &out) {
+		UInt noBlocks = (UInt)((Len + BlockSize - 1) / BlockSize);
+		std::vector<std::vector<unsigned char> > blocks(noBlocks);
+		std::vector<unsigned long long> checksums(noBlocks);
+		Parallel::For(0, noBlocks, 1, [&](size_t b0, size_t b1) {
+			std::vector<unsigned char> scratch;
+			for (size_t b=b0; b<b1; b++) {
+				size_t first = b * BlockSize, blockLen = (Len - first < (size_t)BlockSize) ? Len - first : (size_t)BlockSize;
+				checksums[b] = GetChecksum((const unsigned char *)p + first, blockLen);
+				size_t n = CompressBlock((const unsigned char *)p + first, blockLen, Width, codec, blocks[b], scratch);
+				if (n < blockLen) {
+					blocks[b].resize(n);
+				} else {
+					blocks[b].assign((const unsigned char *)p + first, (const unsigned char *)p + first + blockLen);
+				}
+			}
+		});
+		BinaryWriter w(out);
+		w.Put((UInt)BlockSize);
+		w.Put(noBlocks);
+		w.Put((unsigned long long)Len);
+		unsigned long long end = 0;
+		for (UInt b=0; b<noBlocks; b++) {
+			end += blocks[b].size();
+			w.Put(end);
+		}
+		for (UInt b=0; b<noBlocks; b++) w.Put(checksums[b]);
+		for (UInt b=0; b<noBlocks; b++) {
+			if (!blocks[b].empty()) w.Put(&blocks[b][0], blocks[b].size());
+		}
+	}
+
+	// Description:
+	// Gets the size of the uncompressed buffer of a compressed buffer.
+	//
+	// Arguments:
+	// p       - The compressed buffer.
+	// Len     - The size of the compressed buffer in bytes.
+	// rawSize - Receives the size of the uncompressed buffer in bytes.
+	//
+	// Returns:
+	// true, if the operation succeeded, or false if the compressed
+	// buffer is corrupt.
+	static Bool GetRawSize(const char *p, size_t Len, unsigned long long &rawSize) {
+		BinaryReader r(p, Len);
+		UInt blockSize, noBlocks;
+		return GetHeader(r, blockSize, noBlocks, rawSize);
+	}
+
+	// Description:
+	// Decompresses a buffer compressed by Compress. The blocks are
+	// decompressed in parallel.
+	//
+	// Arguments:
+	// p      - The compressed buffer.
+	// Len    - The size of the compressed buffer in bytes.
+	// Width  - The width of the elements, as passed to Compress.
+	// codec  - The codec, as passed to Compress.
+	// pOut   - The buffer receiving the uncompressed buffer.
+	// outLen - The size of the uncompressed buffer in bytes (see
+	//          GetRawSize).
+	//
+	// Returns:
+	// true, if the operation succeeded, or false if the compressed
+	// buffer is corrupt (as detected by the block checksums).
+	static Bool Decompress(const char *p, size_t Len, size_t Width, CompressionCodec codec, char *pOut, size_t outLen) {
+		size_t noBlocks;
+		if (!GetBlockCount(p, Len, outLen, noBlocks)) return false;
+		std::vector<char> isValid(noBlocks, false);
+		Parallel::For(0, noBlocks, 1, [&](size_t b0, size_t b1) {
+			std::vector<unsigned char> scratch;
+			for (size_t b=b0; b<b1; b++) isValid[b] = DecompressBlock(p, Width, codec, pOut, outLen, b, scratch);
+		});
+		for (size_t b=0; b<noBlocks; b++) {
+			if (!isValid[b]) return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Checks the block directory of a compressed buffer and gets its
+	// number of blocks. Together with DecompressBlock, this allows the
+	// blocks of several buffers to be decompressed in one parallel loop.
+	//
+	// Arguments:
+	// p        - The compressed buffer.
+	// Len      - The size of the compressed buffer in bytes.
+	// outLen   - The size of the uncompressed buffer in bytes (see
+	//            GetRawSize).
+	// noBlocks - Receives the number of blocks.
+	//
+	// Returns:
+	// true, if the operation succeeded, or false if the compressed
+	// buffer is corrupt.
+	static Bool GetBlockCount(const char *p, size_t Len, size_t outLen, size_t &noBlocks) {
+		BinaryReader r(p, Len);
+		UInt blockSize, noBlocks32;
+		unsigned long long rawSize;
+		if (!GetHeader(r, blockSize, noBlocks32, rawSize) || rawSize != outLen) return false;
+		noBlocks = noBlocks32;
+		if (!noBlocks) return true;
+		std::vector<unsigned long long> ends(noBlocks);
+		r.Get(&ends[0], noBlocks * sizeof(unsigned long long));
+		size_t dataLen = r.GetRemaining() - noBlocks * sizeof(unsigned long long);
+		for (size_t b=0; b<noBlocks; b++) {
+			if (ends[b] < (b ? ends[b-1] : 0) || ends[b] > dataLen) return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Decompresses a single block of a compressed buffer whose block
+	// directory has been checked by GetBlockCount.
+	//
+	// Arguments:
+	// p       - The compressed buffer.
+	// Width   - The width of the elements, as passed to Compress.
+	// codec   - The codec, as passed to Compress.
+	// pOut    - The buffer receiving the uncompressed buffer.
+	// outLen  - The size of the uncompressed buffer in bytes.
+	// b       - The index of the block (zero-based).
+	// scratch - A buffer used while decompressing, e.g. reused by one
+	//           thread for all blocks it decompresses.
+	//
+	// Returns:
+	// true, if the operation succeeded, or false if the block is
+	// corrupt (as detected by its checksum).
+	static Bool DecompressBlock(const char *p, size_t Width, CompressionCodec codec, char *pOut, size_t outLen, size_t b,
+		std::vector<unsigned char> &scratch) {
+		UInt blockSize, noBlocks;
+		memcpy(&blockSize, p, sizeof(blockSize));
+		memcpy(&noBlocks, p + sizeof(blockSize), sizeof(noBlocks));
+		const char *pEnds = p + HeaderSize, *pChecksums = pEnds + noBlocks * sizeof(unsigned long long);
+		const unsigned char *pData = (const unsigned char *)pChecksums + noBlocks * sizeof(unsigned long long);
+		unsigned long long start = 0, end, checksum;
+		if (b) memcpy(&start, pEnds + (b - 1) * sizeof(unsigned long long), sizeof(start));
+		memcpy(&end, pEnds + b * sizeof(unsigned long long), sizeof(end));
+		memcpy(&checksum, pChecksums + b * sizeof(unsigned long long), sizeof(checksum));
+		size_t first = b * (size_t)blockSize, blockLen = (outLen - first < blockSize) ? outLen - first : blockSize;
+		unsigned char *pBlock = (unsigned char *)pOut + first;
+		return DecodeBlock(pData + start, (size_t)(end - start), Width, codec, pBlock, blockLen, scratch) &&
+			GetChecksum(pBlock, blockLen) == checksum;
+	}
+
+private:
+	enum {
+		HeaderSize = 2 * sizeof(UInt) + sizeof(unsigned long long), // size of the block size, number of blocks and buffer size
+		HashBits   = 14,   // size of the hash table of the compressor
+		MinMatch   = 4,    // minimum length of a match
+		MaxOffset  = 65535 // maximum distance of a match
+	};
+
+	// reads the header of a compressed buffer and checks its consistency
+	static Bool GetHeader(BinaryReader &r, UInt &blockSize, UInt &noBlocks, unsigned long long &rawSize) {
+		size_t Len = r.GetRemaining();
+		// a block cannot expand more than 255-fold (by a match with length bytes of 255)
+		return r.Get(blockSize) && r.Get(noBlocks) && r.Get(rawSize) && blockSize && rawSize / 255 <= Len &&
+			noBlocks == (rawSize + blockSize - 1) / blockSize && noBlocks <= r.GetRemaining() / (2 * sizeof(unsigned long long));
+	}
+
+	// checksum of an uncompressed block (multiply-xorshift over 8-byte words)
+	static unsigned long long GetChecksum(const unsigned char *p, size_t Len) {
+		unsigned long long h = Len;
+		size_t i = 0;
+		for (; i + 8 <= Len; i += 8) {
+			unsigned long long u;
+			memcpy(&u, p + i, sizeof(u));
+			h = (h ^ u) * 0x9e3779b97f4a7c15ULL;
+			h ^= h >> 29;
+		}
+		for (; i < Len; i++) h = (h ^ p[i]) * 0x100000001b3ULL;
+		return h;
+	}
+
+	// returns the compressed size, or Len if the block does not shrink
+	static size_t CompressBlock(const unsigned char *p, size_t Len, size_t Width, CompressionCodec codec,
+		std::vector<unsigned char> &out, std::vector<unsigned char> &scratch) {
+		if (!Len) return 0;
+		if (codec != CC_LZ) {
+			scratch.resize(Len);
+			Shuffle(p, Len, Width, codec == CC_XOR_SHUFFLE_LZ, &scratch[0]);
+			p = &scratch[0];
+		}
+		out.resize(Len);
+		size_t n = CompressLZ(p, Len, &out[0], Len - 1);
+		return n ? n : Len;
+	}
+
+	static Bool DecodeBlock(const unsigned char *p, size_t Len, size_t Width, CompressionCodec codec,
+		unsigned char *pOut, size_t outLen, std::vector<unsigned char> &scratch) {
+		if (Len == outLen) {
+			// stored uncompressed
+			memcpy(pOut, p, Len);
+			return true;
+		}
+		if (codec == CC_LZ) return DecompressLZ(p, Len, pOut, outLen);
+		scratch.resize(outLen);
+		if (!DecompressLZ(p, Len, &scratch[0], outLen)) return false;
+		Unshuffle(&scratch[0], outLen, Width, codec == CC_XOR_SHUFFLE_LZ, pOut);
+		return true;
+	}
+
+	// XORs every element with its predecessor (optionally) and shuffles the bytes; trailing bytes are copied
+	static void Shuffle(const unsigned char *p, size_t Len, size_t Width, Bool Xor, unsigned char *pOut) {
+		size_t n = Len / Width;
+		for (size_t b=0; n && b<Width; b++) {
+			unsigned char *pDest = pOut + b * n;
+			const unsigned char *pSrc = p + b;
+			pDest[0] = pSrc[0];
+			for (size_t i=1; i<n; i++) pDest[i] = Xor ? pSrc[i * Width] ^ pSrc[(i - 1) * Width] : pSrc[i * Width];
+		}
+		memcpy(pOut + n * Width, p + n * Width, Len - n * Width);
+	}
+
+	static void Unshuffle(const unsigned char *p, size_t Len, size_t Width, Bool Xor, unsigned char *pOut) {
+		size_t n = Len / Width;
+		for (size_t b=0; n && b<Width; b++) {
+			const unsigned char *pSrc = p + b * n;
+			unsigned char *pDest = pOut + b;
+			pDest[0] = pSrc[0];
+			for (size_t i=1; i<n; i++) pDest[i * Width] = Xor ? pSrc[i] ^ pDest[(i - 1) * Width] : pSrc[i];
+		}
+		memcpy(pOut + n * Width, p + n * Width, Len - n * Width);
+	}
+
+	static UInt Read32(const unsigned char *p) {
+		UInt u;
+		memcpy(&u, p, sizeof(u));
+		return u;
+	}
+
+	static UInt Hash(UInt u) {
+		return (u * 2654435761U) >> (32 - HashBits);
+	}
+
+	// Compresses a block into sequences, each consisting of a token (the
+	// number of literals in the high and the match length - MinMatch in
+	// the low nibble; 15 means that further length bytes follow, each
+	// 255 meaning that another one follows), the literals, and the
+	// 16-bit offset and further length bytes of the match. The last
+	// sequence has no match. Returns the compressed size, or 0 if it
+	// would exceed the capacity.
+	static size_t CompressLZ(const unsigned char *p, size_t Len, unsigned char *pOut, size_t capacity) {
+		std::vector<UInt> table(1 << HashBits, 0); // position + 1 of the last occurrence of every hash
+		size_t o = 0, anchor = 0, i = 0;
+		while (i + MinMatch <= Len) {
+			UInt h = Hash(Read32(p + i));
+			size_t candidate = table[h];
+			table[h] = (UInt)(i + 1);
+			if (!candidate || i + 1 - candidate > MaxOffset || Read32(p + candidate - 1) != Read32(p + i)) {
+				// skip faster through incompressible data
+				i += 1 + ((i - anchor) >> 6);
+				continue;
+			}
+			candidate--;
+			size_t matchLen = MinMatch;
+			while (i + matchLen < Len && p[candidate + matchLen] == p[i + matchLen]) matchLen++;
+			if (!PutSequence(pOut, capacity, o, p + anchor, i - anchor, i - candidate, matchLen)) return 0;
+			i += matchLen;
+			anchor = i;
+		}
+		if (!PutSequence(pOut, capacity, o, p + anchor, Len - anchor, 0, 0)) return 0;
+		return o;
+	}
+
+	static Bool PutSequence(unsigned char *pOut, size_t capacity, size_t &o, const unsigned char *pLiterals,
+		size_t litLen, size_t offset, size_t matchLen) {
+		size_t extraLen = matchLen ? matchLen - MinMatch : 0;
+		if (capacity - o < 1 + litLen / 255 + 1 + litLen + 2 + extraLen / 255 + 1) return false;
+		pOut[o++] = (unsigned char)(((litLen < 15 ? litLen : 15) << 4) | (extraLen < 15 ? extraLen : 15));
+		if (litLen >= 15) PutLength(pOut, o, litLen - 15);
+		memcpy(pOut + o, pLiterals, litLen);
+		o += litLen;
+		if (!matchLen) return true;
+		pOut[o++] = (unsigned char)offset;
+		pOut[o++] = (unsigned char)(offset >> 8);
+		if (extraLen >= 15) PutLength(pOut, o, extraLen - 15);
+		return true;
+	}
+
+	static void PutLength(unsigned char *pOut, size_t &o, size_t n) {
+		for (; n >= 255; n -= 255) pOut[o++] = 255;
+		pOut[o++] = (unsigned char)n;
+	}
+
+	static Bool GetLength(const unsigned char *p, size_t Len, size_t &i, size_t &n) {
+		unsigned char b;
+		do {
+			if (i >= Len) return false;
+			b = p[i++];
+			n += b;
+		} while (b == 255);
+		return true;
+	}
+
+	// decompresses a block; every length and offset is checked, so that corrupt data cannot overrun the buffers
+	static Bool DecompressLZ(const unsigned char *p, size_t Len, unsigned char *pOut, size_t outLen) {
+		size_t i = 0, o = 0;
+		while (i < Len) {
+			unsigned char token = p[i++];
+			size_t litLen = token >> 4;
+			if (litLen == 15 && !GetLength(p, Len, i, litLen)) return false;
+			if (litLen > Len - i || litLen > outLen - o) return false;
+			memcpy(pOut + o, p + i, litLen);
+			i += litLen;
+			o += litLen;
+			if (i == Len) break;
+			if (Len - i < 2) return false;
+			size_t offset = p[i] | ((size_t)p[i+1] << 8);
+			i += 2;
+			size_t matchLen = token & 15;
+			if (matchLen == 15 && !GetLength(p, Len, i, matchLen)) return false;
+			matchLen += MinMatch;
+			if (!offset || offset > o || matchLen > outLen - o) return false;
+			const unsigned char *pMatch = pOut + o - offset;
+			if (offset >= matchLen) {
+				memcpy(pOut + o, pMatch, matchLen);
+			} else {
+				// overlapping match, e.g. a run
+				for (size_t k=0; k<matchLen; k++) pOut[o+k] = pMatch[k];
+			}
+			o += matchLen;
+		}
+		return o == outLen;
+	}
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_BLOCKCOMPRESSION_H_INCLUDED */
@@ -0,0 +1,83 @@
+#ifndef DCI_BUFFEREDWRITER_H_INCLUDED
+#define DCI_BUFFEREDWRITER_H_INCLUDED
+
+#include "DCI/DCI.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// Description: Buffered Writer Class.
+//
+// Writes data to a file through a large buffer, so that many small
+// pieces (e.g. the offsets and characters of the strings of a column)
+// result in few large fwrite calls. Pieces at least as large as the
+// buffer (e.g. the values of an integer or double column) are written
+// with a single fwrite call, bypassing the buffer.
+//
+// Errors are sticky: after a failed write, all further writes are
+// skipped, so that callers only need to check the result of Flush.
+class BufferedWriter {
+public:
+	enum {
+		DefaultBufferSize = 4 << 20 // size of the buffer in bytes
+	};
+
+	// Description:
+	// Constructs a buffered writer.
+	//
+	// Arguments:
+	// fp         - The file pointer of the file. The file is not closed
+	//              by the writer.
+	// BufferSize - The size of the buffer in bytes.
+	BufferedWriter(FILE *fp, size_t BufferSize = DefaultBufferSize) : m_fp(fp), m_Buffer(BufferSize ? BufferSize : 1), m_Len(0), m_IsOK(true) {}
+	~BufferedWriter() {
+		Flush();
+	}
+
+	// Description:
+	// Writes data.
+	//
+	// Arguments:
+	// p   - The data.
+	// Len - The size of the data in bytes.
+	void Put(const void *p, size_t Len) {
+		if (!m_IsOK) return;
+		if (Len > m_Buffer.size() - m_Len) {
+			if (!Flush()) return;
+			if (Len >= m_Buffer.size()) {
+				m_IsOK = fwrite(p, 1, Len, m_fp) == Len;
+				return;
+			}
+		}
+		memcpy(&m_Buffer[m_Len], p, Len);
+		m_Len += Len;
+	}
+
+	// Description:
+	// Writes the buffered data to the file.
+	//
+	// Returns:
+	// true, if all data has been written successfully, false otherwise.
+	Bool Flush() {
+		if (m_Len && m_IsOK) m_IsOK = fwrite(&m_Buffer[0], 1, m_Len, m_fp) == m_Len;
+		m_Len = 0;
+		return m_IsOK;
+	}
+
+private:
+	BufferedWriter(const BufferedWriter &);
+	BufferedWriter &operator = (const BufferedWriter &);
+
+	FILE             *m_fp;
+	std::vector<char> m_Buffer;
+	size_t            m_Len;  // number of bytes in the buffer
+	Bool              m_IsOK; // no write has failed
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_BUFFEREDWRITER_H_INCLUDED */
@@ -0,0 +1,325 @@
+#ifndef DCI_CHANGETRACKER_H_INCLUDED
+#define DCI_CHANGETRACKER_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+#include "DCI/TableOperations.h"
+
+#include <map>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Row Range.
+//
+// A range of records (rows) of a table. Both indexes are 1-based and
+// inclusive.
+struct RowRange {
+	UInt First; // Index of the first record of the range.
+	UInt Last;  // Index of the last record of the range.
+};
+
+// {group:Data Classes}
+// Description: Column Changes.
+//
+// The changes of a column of a table, as returned by
+// ChangeTracker::GetChanges.
+struct ColumnChanges {
+	UInt                  ColIdx;  // Index of the column. The index of the first column is 1.
+	unsigned long long    Version; // Version of the last change of the column.
+	std::vector<RowRange> Ranges;  // Changed records, ascending and non-overlapping.
+};
+
+// {group:Data Classes}
+// Description: Change Tracker Class.
+//
+// A change tracker records which records (rows) of which columns of a
+// table have changed, so that consumers can process only the changes
+// instead of the whole table.
+//
+// Every change increments the tracker's version; each column keeps the
+// version of its last change, and its changed records are kept as
+// coalesced ranges, each range tagged with the version of its last
+// change. GetChanges returns the changes since a specified version,
+// and Clear discards changes up to a specified version.
+//
+// Changes are recorded when the table is modified through the tracker
+// (SetValue, SetValues, AppendRecords) or when reported by MarkChanged.
+// Optionally, the tracker also detects changes made by other means (see
+// Detect); for this purpose, it holds a reference to the value vector
+// every column had at the last Detect. Please note, that this makes
+// the first write of a column through SetValue (or IVariable::SetValue)
+// after each Detect copy the column's values (see VectorRepBase), and
+// that the vector replaced by a SetValues call is kept until the next
+// Detect. Columns are identified by their keys, so columns added,
+// removed or moved keep their recorded changes.
+class ChangeTracker {
+public:
+	// Description:
+	// Constructs a change tracker for a table.
+	//
+	// Arguments:
+	// hTable         - The handle of the table to be tracked.
+	// detectExternal - true if changes made without the tracker should
+	//                  be detected by Detect.
+	ChangeTracker() : m_Version(0), m_DetectExternal(false) {}
+	ChangeTracker(const ITableHandle &hTable, Bool detectExternal = false) : m_Version(0), m_DetectExternal(false) {
+		Attach(hTable, detectExternal);
+	}
+
+	// Description:
+	// Binds the tracker to a (possibly different) table. All recorded
+	// changes are discarded; the version is not reset.
+	void Attach(const ITableHandle &hTable, Bool detectExternal = false) {
+		m_Table = hTable;
+		m_DetectExternal = detectExternal;
+		m_Columns.clear();
+		Resize();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the current version, i.e. the version of the latest
+	// change.
+	unsigned long long GetVersion() const {
+		return m_Version;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the version of the latest change of a column, or 0 if
+	// the column has not changed.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	unsigned long long GetVersion(UInt colIdx) const {
+		return (colIdx >= 1 && colIdx <= m_Columns.size()) ? m_Columns[colIdx-1].Version : 0;
+	}
+
+	// Description:
+	// Sets the value of a field (cell) of the table and records the
+	// change (see ITable::SetValue).
+	Bool SetValue(UInt recIdx, UInt colIdx, const Value &newValue) {
+		if (!m_Table->SetValue(recIdx, colIdx, newValue)) return false;
+		MarkChanged(colIdx, recIdx, recIdx);
+		return true;
+	}
+	Bool SetValue(UInt recIdx, const String &colKey, const Value &newValue) {
+		return SetValue(recIdx, m_Table->GetColumns()->IndexOf(colKey), newValue);
+	}
+
+	// Description:
+	// Sets the values of a column and records the change (see
+	// IVariable::SetValues). For columns with fixed-width values, only
+	// the range of records whose values actually differ is recorded.
+	Bool SetValues(UInt colIdx, const Vector &newValues) {
+		IVariableHandle hCol = m_Table->GetColumn(colIdx);
+		if (!hCol) return false;
+		Vector oldValues = hCol->GetValues();
+		if (!hCol->SetValues(newValues)) return false;
+		RecordDifference(colIdx, oldValues, hCol->GetValues());
+		return true;
+	}
+	Bool SetValues(const String &colKey, const Vector &newValues) {
+		return SetValues(m_Table->GetColumns()->IndexOf(colKey), newValues);
+	}
+
+	// Description:
+	// Appends records to the table and records the new records of all
+	// columns as changed (see TableOperations::AppendRecords).
+	Bool AppendRecords(const Vector *newValues, UInt noCols) {
+		IVariablesHandle hCols = m_Table->GetColumns();
+		UInt noRecs = hCols->GetCount() ? hCols->Item(1)->GetLength() : 0;
+		if (!TableOperations::AppendRecords(m_Table, newValues, noCols)) return false;
+		UInt newNoRecs = hCols->GetCount() ? hCols->Item(1)->GetLength() : 0;
+		for (UInt c=1; c<=hCols->GetCount(); c++) MarkChanged(c, noRecs + 1, newNoRecs);
+		return true;
+	}
+
+	// Description:
+	// Records a change of a range of records of a column made without
+	// the tracker.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	// first  - Index of the first changed record (1-based).
+	// last   - Index of the last changed record (1-based, inclusive).
+	void MarkChanged(UInt colIdx, UInt first, UInt last) {
+		if (colIdx < 1 || first < 1 || last < first || !m_Table) return;
+		if (colIdx > m_Columns.size() || m_Columns[colIdx-1].Key != m_Table->GetColumns()->KeyOf(colIdx)) {
+			Resize();
+			if (colIdx > m_Columns.size()) return;
+		}
+		Column &column = m_Columns[colIdx-1];
+		column.Version = ++m_Version;
+		Insert(column.Ranges, first, last, m_Version);
+	}
+
+	// Description:
+	// Detects changes made without the tracker by comparing every
+	// column's value vector to the vector seen last. For columns with
+	// fixed-width values, the range of records whose values differ is
+	// recorded; otherwise, all records are recorded as changed. Since
+	// the vectors are only kept by Detect, records changed through the
+	// tracker after the last Detect are recorded again (with a newer
+	// version). Only available if external detection was enabled.
+	void Detect() {
+		if (!m_DetectExternal || !m_Table) return;
+		Resize();
+		IVariablesHandle hCols = m_Table->GetColumns();
+		for (UInt c=1; c<=m_Columns.size(); c++) {
+			Column &column = m_Columns[c-1];
+			Vector current = hCols->Item(c)->GetValues();
+			if (!ColumnData::IsSameData(current, column.Snapshot)) RecordDifference(c, column.Snapshot, current);
+			column.Snapshot = current;
+		}
+	}
+
+	// Description:
+	// Returns the changes made after a specified version.
+	//
+	// Arguments:
+	// sinceVersion - The version after which the changes are returned,
+	//                e.g. the result of GetVersion when the caller last
+	//                processed the changes. 0 returns all changes.
+	//
+	// Returns:
+	// The changes of all columns changed after the version, in column
+	// order. Ranges coalesced from older and newer changes are returned
+	// as a whole.
+	std::vector<ColumnChanges> GetChanges(unsigned long long sinceVersion = 0) const {
+		std::vector<ColumnChanges> changes;
+		for (UInt c=1; c<=m_Columns.size(); c++) {
+			const Column &column = m_Columns[c-1];
+			if (column.Version <= sinceVersion) continue;
+			ColumnChanges colChanges;
+			colChanges.ColIdx  = c;
+			colChanges.Version = column.Version;
+			for (RangeMap::const_iterator it = column.Ranges.begin(); it != column.Ranges.end(); ++it) {
+				if (it->second.Version <= sinceVersion) continue;
+				RowRange range = { it->first, it->second.Last };
+				colChanges.Ranges.push_back(range);
+			}
+			changes.push_back(colChanges);
+		}
+		return changes;
+	}
+
+	// Description:
+	// Discards the changes made up to (and including) a specified
+	// version. The versions of the columns are kept.
+	//
+	// Arguments:
+	// upToVersion - The version up to which the changes are discarded.
+	//               By default, all changes are discarded.
+	void Clear(unsigned long long upToVersion = ~0ULL) {
+		for (size_t c=0; c<m_Columns.size(); c++) {
+			RangeMap &ranges = m_Columns[c].Ranges;
+			for (RangeMap::iterator it = ranges.begin(); it != ranges.end(); ) {
+				if (it->second.Version <= upToVersion) it = ranges.erase(it);
+				else ++it;
+			}
+		}
+	}
+
+private:
+	// {internal}
+	// Description:
+	// Changed range of records, keyed by its first record.
+	struct Range {
+		UInt               Last;
+		unsigned long long Version;
+	};
+	typedef std::map<UInt, Range> RangeMap;
+
+	// {internal}
+	// Description:
+	// Change state of a column.
+	struct Column {
+		String             Key;      // key of the column
+		unsigned long long Version;
+		RangeMap           Ranges;
+		Vector             Snapshot; // the value vector seen by the last Detect (external detection only)
+
+		Column() : Version(0) {}
+	};
+
+	// matches the column states to the columns of the table by their keys,
+	// adapting them to columns added, removed or moved
+	void Resize() {
+		if (!m_Table) return;
+		IVariablesHandle hCols = m_Table->GetColumns();
+		UInt noCols = hCols->GetCount();
+		Bool isSame = noCols == m_Columns.size();
+		for (UInt c=0; isSame && c<noCols; c++) isSame = m_Columns[c].Key == hCols->KeyOf(c+1);
+		if (isSame) return;
+		std::vector<Column> columns(noCols);
+		for (UInt c=0; c<noCols; c++) {
+			String key = hCols->KeyOf(c+1);
+			size_t i = 0;
+			while (i < m_Columns.size() && m_Columns[i].Key != key) i++;
+			if (i < m_Columns.size()) {
+				columns[c] = m_Columns[i];
+				continue;
+			}
+			columns[c].Key = key;
+			if (m_DetectExternal) columns[c].Snapshot = hCols->Item(c+1)->GetValues();
+		}
+		m_Columns.swap(columns);
+	}
+
+	// inserts a range, coalescing it with overlapping and adjacent ranges
+	static void Insert(RangeMap &ranges, UInt first, UInt last, unsigned long long version) {
+		RangeMap::iterator it = ranges.upper_bound(first);
+		if (it != ranges.begin()) {
+			RangeMap::iterator prev = it;
+			--prev;
+			if (prev->second.Last + 1 >= first) {
+				first = prev->first;
+				if (prev->second.Last > last) last = prev->second.Last;
+				ranges.erase(prev);
+			}
+		}
+		while (it != ranges.end() && it->first <= last + 1) {
+			if (it->second.Last > last) last = it->second.Last;
+			it = ranges.erase(it);
+		}
+		Range range = { last, version };
+		ranges[first] = range;
+	}
+
+	// records the records differing between two value vectors of a column
+	void RecordDifference(UInt colIdx, const Vector &oldValues, const Vector &newValues) {
+		size_t oldLen = oldValues.Len(), newLen = newValues.Len();
+		size_t maxLen = oldLen > newLen ? oldLen : newLen;
+		size_t first = 0, last = maxLen;
+		DataType dt = newLen ? newValues.GetDataType() : oldValues.GetDataType();
+		if (ColumnData::IsFixedWidth(dt) && oldValues.GetDataType() == newValues.GetDataType()) {
+			size_t size = ColumnData::GetElementSize(dt);
+			const char *pOld = (const char *)ColumnData::GetDataPtr(oldValues);
+			const char *pNew = (const char *)ColumnData::GetDataPtr(newValues);
+			size_t minLen = oldLen < newLen ? oldLen : newLen;
+			if (pOld != pNew) {
+				while (first < minLen && !memcmp(pOld + first * size, pNew + first * size, size)) first++;
+			} else {
+				first = minLen;
+			}
+			if (oldLen == newLen) {
+				while (last > first && !memcmp(pOld + (last - 1) * size, pNew + (last - 1) * size, size)) last--;
+			}
+		}
+		if (last > first) MarkChanged(colIdx, (UInt)first + 1, (UInt)last);
+	}
+
+	ITableHandle        m_Table;
+	unsigned long long  m_Version;        // version of the latest change
+	Bool                m_DetectExternal; // snapshots are kept
+	std::vector<Column> m_Columns;
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_CHANGETRACKER_H_INCLUDED */
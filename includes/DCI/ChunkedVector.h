@@ -0,0 +1,386 @@
+#ifndef DCI_CHUNKEDVECTOR_H_INCLUDED
+#define DCI_CHUNKEDVECTOR_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ColumnData.h"
+#include "DCI/Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Chunked Vector Class Template.
+//
+// A chunked vector stores the values of a column in a list of
+// separately allocated chunks (segments) of a fixed number of elements,
+// instead of in one contiguous block like Vector. Appending elements
+// only ever allocates a new chunk: existing chunks are never moved or
+// copied, and no single allocation exceeds the chunk size, so that
+// even very large columns grow in constant time per element and do not
+// fragment the address space.
+//
+// The chunk size is a power of two, so that the chunk holding an
+// element is found by a shift. Chunks are the natural unit for parallel
+// processing (see ForEachChunk) and for I/O (every chunk of a
+// fixed-width column is written with a single fwrite). T is one of
+// Byte, Int, Double and String. Elements are indexed from 0, as with
+// Vector.
+//
+// Chunks are reference counted and copied on write at chunk
+// granularity: copying a chunked vector only shares its chunks, and
+// writing an element of a shared chunk copies that chunk alone, while
+// all other chunks stay shared between the copy and the original.
+// Please note, that any non-const access to an element or a chunk
+// counts as a write.
+//
+// The reference counts of the chunks are atomic, so that copies of a
+// chunked vector of Byte, Int or Double elements can be used on
+// different threads. This does not hold for String elements, whose own
+// reference counts are not atomic: copies of a ChunkedVector<String>
+// sharing chunks must only be used on one thread, and functions passed
+// to ForEachChunk must not copy its strings.
+//
+// Example:
+//   ChunkedVector<Double> time;
+//   for (...) time.Append(t);
+//   hTable->GetColumn("Time")->SetValues(time.ToVector());
+template<class T> class ChunkedVector {
+public:
+	enum {
+		DefaultChunkSize = 64 * 1024 // default number of elements per chunk
+	};
+
+	// Description:
+	// Constructs a chunked vector.
+	//
+	// Arguments:
+	// chunkSize - The number of elements per chunk. It is rounded up to
+	//             a power of two.
+	// v         - The vector whose elements are copied. Its data type
+	//             must match T.
+	// fp        - The file pointer of a file storing a chunked vector
+	//             (see SaveToBinaryFile).
+	ChunkedVector(size_t chunkSize = DefaultChunkSize) : m_Len(0) {
+		SetChunkSize(chunkSize);
+	}
+	ChunkedVector(const Vector &v, size_t chunkSize = DefaultChunkSize) : m_Len(0) {
+		SetChunkSize(chunkSize);
+		Append(v);
+	}
+	ChunkedVector(const ChunkedVector &v) : m_Len(0), m_Shift(v.m_Shift) {
+		Share(v);
+	}
+	ChunkedVector(FILE *fp) : m_Len(0) {
+		SetChunkSize(DefaultChunkSize);
+		LoadFromBinaryFile(fp);
+	}
+	~ChunkedVector() {
+		Clear();
+	}
+
+	ChunkedVector &operator = (const ChunkedVector &v) {
+		if (this != &v) {
+			Clear();
+			m_Shift = v.m_Shift;
+			Share(v);
+		}
+		return *this;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of elements.
+	size_t Len() const {
+		return m_Len;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of elements per chunk.
+	size_t GetChunkSize() const {
+		return (size_t)1 << m_Shift;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of chunks.
+	size_t GetChunkCount() const {
+		return m_Chunks.size();
+	}
+
+	// Description:
+	// Returns the number of elements of a chunk. All chunks but the last
+	// one are full.
+	//
+	// Arguments:
+	// chunkIdx - Index of the chunk (0-based).
+	size_t GetChunkLen(size_t chunkIdx) const {
+		size_t first = chunkIdx << m_Shift;
+		return first >= m_Len ? 0 : std::min<size_t>(GetChunkSize(), m_Len - first);
+	}
+
+	// Description:
+	// Tests if a chunk is shared with another chunked vector.
+	//
+	// Arguments:
+	// chunkIdx - Index of the chunk (0-based).
+	Bool IsShared(size_t chunkIdx) const {
+		return chunkIdx < m_Chunks.size() && m_Chunks[chunkIdx]->RefCount > 1;
+	}
+
+	// Description:
+	// Returns a pointer to the first element of a chunk. The pointer
+	// stays valid until the chunk is removed (see ReDim and Clear) or,
+	// for the read-only pointer, until the chunk is written to;
+	// appending elements does not move any chunk. The writable pointer
+	// unshares the chunk first.
+	//
+	// Arguments:
+	// chunkIdx - Index of the chunk (0-based).
+	const T *GetChunk(size_t chunkIdx) const {
+		return chunkIdx < m_Chunks.size() ? m_Chunks[chunkIdx]->Data : 0;
+	}
+	T *GetChunk(size_t chunkIdx) {
+		return chunkIdx < m_Chunks.size() ? GetWritable(chunkIdx) : 0;
+	}
+
+	// Description:
+	// Returns an element. The index must be less than Len(). The
+	// writable reference unshares the element's chunk first.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	const T &operator [] (size_t Index) const {
+		return m_Chunks[Index >> m_Shift]->Data[Index & GetMask()];
+	}
+	T &operator [] (size_t Index) {
+		return GetWritable(Index >> m_Shift)[Index & GetMask()];
+	}
+
+	// Description:
+	// Appends elements. Only the last chunk is written to, and new
+	// chunks are allocated as needed.
+	//
+	// Arguments:
+	// value - The element to be appended.
+	// p     - Pointer to the first of the elements to be appended.
+	// Len   - The number of elements to be appended.
+	// v     - The vector or chunked vector whose elements are appended.
+	//         The data type of a vector must match T.
+	//
+	// Returns:
+	// true if the method succeeds, or false if the data type of the
+	// vector does not match.
+	void Append(const T &value) {
+		if (!(m_Len & GetMask()) && (m_Len >> m_Shift) == m_Chunks.size()) AddChunk();
+		(*this)[m_Len++] = value;
+	}
+	void Append(const T *p, size_t Len) {
+		while (Len) {
+			size_t offset = m_Len & GetMask();
+			if (!offset && (m_Len >> m_Shift) == m_Chunks.size()) AddChunk();
+			size_t n = std::min<size_t>(Len, GetChunkSize() - offset);
+			std::copy(p, p + n, GetWritable(m_Len >> m_Shift) + offset);
+			m_Len += n;
+			p += n;
+			Len -= n;
+		}
+	}
+	Bool Append(const Vector &v) {
+		if (!v.Len()) return true;
+		if (v.GetDataType() != ColumnType<T>::GetDataType()) return false;
+		Append(typename ColumnType<T>::VectorType(v).GetPtr(), v.Len());
+		return true;
+	}
+	void Append(const ChunkedVector &v) {
+		if (v.m_Shift == m_Shift && !(m_Len & GetMask())) {
+			Share(v);
+			return;
+		}
+		for (size_t c=0; c<v.GetChunkCount(); c++) Append(v.GetChunk(c), v.GetChunkLen(c));
+	}
+
+	// Description:
+	// Changes the number of elements. New elements are value-initialized
+	// (0 or an empty string); chunks no longer needed are freed.
+	void ReDim(size_t Len) {
+		if (Len < m_Len) {
+			size_t noChunks = (Len + GetMask()) >> m_Shift;
+			for (size_t c=noChunks; c<m_Chunks.size(); c++) Release(m_Chunks[c]);
+			m_Chunks.resize(noChunks);
+			for (size_t i=Len; i<(noChunks << m_Shift) && i<m_Len; i++) (*this)[i] = T();
+			m_Len = Len;
+		}
+		while (m_Len < Len) {
+			if (!(m_Len & GetMask()) && (m_Len >> m_Shift) == m_Chunks.size()) AddChunk();
+			m_Len = std::min<size_t>(Len, ((m_Len >> m_Shift) + 1) << m_Shift);
+		}
+	}
+
+	// Description:
+	// Removes all elements and frees all chunks.
+	void Clear() {
+		for (size_t c=0; c<m_Chunks.size(); c++) Release(m_Chunks[c]);
+		m_Chunks.clear();
+		m_Len = 0;
+	}
+
+	// Description:
+	// Copies the elements to a (contiguous) vector.
+	typename ColumnType<T>::VectorType ToVector() const {
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, m_Len);
+		if (!p) return v;
+		for (size_t c=0; c<m_Chunks.size(); c++) std::copy(m_Chunks[c]->Data, m_Chunks[c]->Data + GetChunkLen(c), p + (c << m_Shift));
+		return v;
+	}
+
+	// Description:
+	// Calls a function for every chunk; the chunks are processed in
+	// parallel (see Parallel::For). The function must not modify the
+	// chunked vector other than through the pointer it is passed. The
+	// non-const version unshares all chunks first.
+	//
+	// Arguments:
+	// f - The function, called as f(p, Len, first), where p points to
+	//     the first element of the chunk, Len is the number of elements
+	//     of the chunk and first is the index of its first element.
+	template<class F> void ForEachChunk(F f) const {
+		Parallel::For(0, m_Chunks.size(), 1, [this, &f](size_t first, size_t last) {
+			for (size_t c=first; c<last; c++) f((const T *)m_Chunks[c]->Data, GetChunkLen(c), c << m_Shift);
+		});
+	}
+	template<class F> void ForEachChunk(F f) {
+		for (size_t c=0; c<m_Chunks.size(); c++) GetWritable(c);
+		Parallel::For(0, m_Chunks.size(), 1, [this, &f](size_t first, size_t last) {
+			for (size_t c=first; c<last; c++) f(m_Chunks[c]->Data, GetChunkLen(c), c << m_Shift);
+		});
+	}
+
+	// Description:
+	// Saves the chunked vector to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		Int type = ColumnType<T>::GetDataType();
+		unsigned long long len = m_Len, shift = m_Shift;
+		if (fwrite(&type, sizeof(type), 1, fp) != 1 || fwrite(&len, sizeof(len), 1, fp) != 1 ||
+			fwrite(&shift, sizeof(shift), 1, fp) != 1) return false;
+		for (size_t c=0; c<m_Chunks.size(); c++) {
+			if (!Write(m_Chunks[c]->Data, GetChunkLen(c), fp)) return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Loads a chunked vector from a binary file written by
+	// SaveToBinaryFile. The chunk size is taken from the file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		Int type;
+		unsigned long long len, shift;
+		Clear();
+		if (fread(&type, sizeof(type), 1, fp) != 1 || fread(&len, sizeof(len), 1, fp) != 1 ||
+			fread(&shift, sizeof(shift), 1, fp) != 1) return false;
+		if (type != ColumnType<T>::GetDataType() || shift >= 8 * sizeof(size_t)) return false;
+		m_Shift = (size_t)shift;
+		while (m_Len < len) {
+			AddChunk();
+			size_t n = (size_t)std::min<unsigned long long>(GetChunkSize(), len - m_Len);
+			if (!Read(m_Chunks.back()->Data, n, fp)) {
+				Clear();
+				return false;
+			}
+			m_Len += n;
+		}
+		return true;
+	}
+
+private:
+	// {internal}
+	// Description:
+	// Reference counted chunk.
+	struct Chunk {
+		std::atomic<int> RefCount;
+		T               *Data;
+
+		Chunk(size_t Len) : RefCount(1), Data(new T[Len]()) {}
+		~Chunk() { delete[] Data; }
+	};
+
+	static void Release(Chunk *pChunk) {
+		if (--pChunk->RefCount == 0) delete pChunk;
+	}
+
+	// appends all chunks of another chunked vector (with the same chunk size) by sharing them
+	void Share(const ChunkedVector &v) {
+		size_t noChunks = v.m_Chunks.size(), len = v.m_Len;
+		for (size_t c=0; c<noChunks; c++) {
+			v.m_Chunks[c]->RefCount++;
+			m_Chunks.push_back(v.m_Chunks[c]);
+		}
+		m_Len += len;
+	}
+
+	// unshares a chunk by copying its elements, so that it can be written to
+	T *GetWritable(size_t chunkIdx) {
+		Chunk *pChunk = m_Chunks[chunkIdx];
+		if (pChunk->RefCount > 1) {
+			Chunk *pCopy = new Chunk(GetChunkSize());
+			std::copy(pChunk->Data, pChunk->Data + GetChunkLen(chunkIdx), pCopy->Data);
+			Release(pChunk);
+			m_Chunks[chunkIdx] = pChunk = pCopy;
+		}
+		return pChunk->Data;
+	}
+
+	size_t GetMask() const {
+		return GetChunkSize() - 1;
+	}
+
+	void SetChunkSize(size_t chunkSize) {
+		for (m_Shift = 0; ((size_t)1 << m_Shift) < chunkSize; m_Shift++);
+	}
+
+	void AddChunk() {
+		m_Chunks.push_back(new Chunk(GetChunkSize()));
+	}
+
+	template<class U> static Bool Write(const U *p, size_t Len, FILE *fp) {
+		return fwrite(p, sizeof(U), Len, fp) == Len;
+	}
+	static Bool Write(const String *p, size_t Len, FILE *fp) {
+		for (size_t i=0; i<Len; i++) {
+			if (!p[i].SaveToBinaryFile(fp)) return false;
+		}
+		return true;
+	}
+	template<class U> static Bool Read(U *p, size_t Len, FILE *fp) {
+		return fread(p, sizeof(U), Len, fp) == Len;
+	}
+	static Bool Read(String *p, size_t Len, FILE *fp) {
+		for (size_t i=0; i<Len; i++) p[i] = String(fp);
+		return !ferror(fp) && !feof(fp);
+	}
+
+	size_t               m_Len;    // number of elements
+	size_t               m_Shift;  // log2 of the chunk size
+	std::vector<Chunk *> m_Chunks; // all chunks are full except for the last one
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_CHUNKEDVECTOR_H_INCLUDED */
@@ -0,0 +1,255 @@
+#ifndef DCI_COLUMNARENA_H_INCLUDED
+#define DCI_COLUMNARENA_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/Error.h"
+#include "DCI/ColumnData.h"
+
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Column Arena Class.
+//
+// A column arena holds a copy of all fixed-width columns (bytes,
+// integers, doubles, date/time values and enumerations) of a
+// record-based table in one contiguous memory block. The block is
+// allocated at once when the arena is redimensioned; each column
+// occupies a cache-line aligned slice of the block, one column after
+// the other. Full-table scans thus walk a single, predictable memory
+// range.
+//
+// The arena is a detached snapshot, not the table's storage: Load
+// copies the values, so the data is held twice while the arena is
+// loaded, and changes of the table or of the arena are not seen by the
+// other side until Load or Store is called again. Store allocates one
+// new vector per column and assigns it with IVariable::SetValues, which
+// validates all values of the column; the arena thus pays off for
+// repeated scans rather than for a single pass.
+//
+// Columns with complex data types (strings, values) are not part of
+// the arena; GetColumnPtr returns NULL for them.
+class ColumnArena {
+public:
+	// Description:
+	// Constructs an empty arena.
+	ColumnArena() : m_Buffer(0), m_Block(0), m_Size(0), m_NoRecs(0) {}
+
+	// Description:
+	// Destructs the arena and frees its memory block.
+	~ColumnArena() {
+		Free();
+	}
+
+	// Description:
+	// Changes the dimension of the arena. The previous content is
+	// discarded and a new memory block large enough to hold all
+	// fixed-width columns is allocated in a single allocation.
+	//
+	// Arguments:
+	// noRecs    - The number of records (rows).
+	// noCols    - The number of columns.
+	// dataTypes - The data types of the columns (noCols elements).
+	//
+	// Returns:
+	// true if the memory block was allocated, or false otherwise.
+	Bool ReDim(UInt noRecs, UInt noCols, const DataType *dataTypes) {
+		Free();
+		size_t size = 0;
+		m_Slots.resize(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			m_Slots[i].Type = ColumnData::GetStorageType(dataTypes[i]);
+			size_t elemSize = ColumnData::GetElementSize(m_Slots[i].Type);
+			if (!elemSize) {
+				m_Slots[i].Offset = SIZE_T_MAX;
+				continue;
+			}
+			m_Slots[i].Offset = size;
+			size += (elemSize * noRecs + Alignment - 1) & ~(Alignment - 1);
+		}
+		m_NoRecs = noRecs;
+		if (!size) return true;
+		m_Buffer = (char *)malloc(size + Alignment - 1);
+		if (!m_Buffer) {
+			m_Slots.clear();
+			m_NoRecs = 0;
+			return false;
+		}
+		m_Block = (char *)(((size_t)m_Buffer + Alignment - 1) & ~(Alignment - 1));
+		m_Size  = size;
+		return true;
+	}
+
+	// Description:
+	// Redimensions the arena to match a record-based table and copies
+	// the data of all fixed-width columns of the table into the arena.
+	//
+	// Arguments:
+	// hTable - The handle of the record-based table to be loaded.
+	//
+	// Returns:
+	// true if the table was loaded, or false otherwise.
+	Bool Load(ITableHandle &hTable) {
+		if (!hTable->GetRecordBased()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The table must be record-based.");
+			return false;
+		}
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = hCols->GetCount();
+		std::vector<Vector>   values(noCols);
+		std::vector<DataType> dataTypes(noCols);
+		UInt noRecs = 0;
+		for (UInt i=0; i<noCols; i++) {
+			values[i]    = hCols->Item(i+1)->GetValues();
+			dataTypes[i] = values[i].GetDataType();
+			if (values[i].Len() > noRecs) noRecs = (UInt)values[i].Len();
+		}
+		if (!ReDim(noRecs, noCols, noCols ? &dataTypes[0] : 0)) return false;
+		for (UInt i=0; i<noCols; i++) {
+			if (m_Slots[i].Offset == SIZE_T_MAX || !values[i].Len()) continue;
+			const void *pSrc = 0;
+			switch (m_Slots[i].Type) {
+				case DT_BYTE:   pSrc = ColumnData::GetPtr<Byte>(values[i]);   break;
+				case DT_INT:    pSrc = ColumnData::GetPtr<Int>(values[i]);    break;
+				case DT_DOUBLE: pSrc = ColumnData::GetPtr<Double>(values[i]); break;
+				default:        break;
+			}
+			if (pSrc) memcpy(m_Block + m_Slots[i].Offset, pSrc, values[i].Len() * ColumnData::GetElementSize(m_Slots[i].Type));
+		}
+		return true;
+	}
+
+	// Description:
+	// Writes the data of all fixed-width columns in the arena back to
+	// a record-based table. The table must have the same schema and
+	// number of records as the arena. The vectors of all columns are
+	// built before the table is modified; if a column rejects its
+	// values, the columns already written are restored to their
+	// original values.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be written to.
+	//
+	// Returns:
+	// true if all columns were written, or false otherwise.
+	Bool Store(ITableHandle &hTable) const {
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = GetColumnCount();
+		if (hCols->GetCount() != noCols) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The number of columns does not match the arena.");
+			return false;
+		}
+		std::vector<Vector> values(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			switch (m_Slots[i].Type) {
+				case DT_BYTE:   values[i] = GetColumnValues<Byte>(i);   break;
+				case DT_INT:    values[i] = GetColumnValues<Int>(i);    break;
+				case DT_DOUBLE: values[i] = GetColumnValues<Double>(i); break;
+				default:        continue;
+			}
+			if (values[i].Len() != m_NoRecs) return false;
+		}
+		std::vector<Vector> oldValues(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			if (m_Slots[i].Offset == SIZE_T_MAX) continue;
+			IVariableHandle hCol = hCols->Item(i+1);
+			oldValues[i] = hCol->GetValues();
+			if (!hCol->SetValues(values[i])) {
+				for (UInt j=0; j<i; j++) {
+					if (m_Slots[j].Offset != SIZE_T_MAX) hCols->Item(j+1)->SetValues(oldValues[j]);
+				}
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of records (rows) of the arena.
+	UInt GetRecordCount() const {
+		return m_NoRecs;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of columns of the arena, including columns
+	// with complex data types which are not stored in the arena.
+	UInt GetColumnCount() const {
+		return (UInt)m_Slots.size();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the storage data type of a column.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	DataType GetDataType(UInt colIdx) const {
+		return (colIdx >= 1 && colIdx <= GetColumnCount()) ? m_Slots[colIdx-1].Type : DT_VOID;
+	}
+
+	// Description:
+	// Returns a pointer to the first element of a column in the arena.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	//
+	// Returns:
+	// The pointer to the column's elements, or NULL if the column index
+	// is invalid, the column is not stored in the arena or T does not
+	// match the storage data type of the column.
+	template<class T> T *GetColumnPtr(UInt colIdx) {
+		if (colIdx < 1 || colIdx > GetColumnCount()) return 0;
+		const Slot &slot = m_Slots[colIdx-1];
+		if (slot.Offset == SIZE_T_MAX || slot.Type != ColumnType<T>::GetDataType() || !m_Block) return 0;
+		return (T *)(m_Block + slot.Offset);
+	}
+	template<class T> const T *GetColumnPtr(UInt colIdx) const {
+		return const_cast<ColumnArena *>(this)->GetColumnPtr<T>(colIdx);
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the size of the arena's memory block in bytes.
+	size_t GetSize() const {
+		return m_Size;
+	}
+
+private:
+	ColumnArena(const ColumnArena &);             // not implemented
+	ColumnArena &operator = (const ColumnArena &); // not implemented
+
+	template<class T> Vector GetColumnValues(UInt i) const {
+		if (!m_NoRecs) return typename ColumnType<T>::VectorType();
+		return typename ColumnType<T>::VectorType((const T *)(m_Block + m_Slots[i].Offset), m_NoRecs);
+	}
+
+	void Free() {
+		free(m_Buffer);
+		m_Buffer = m_Block = 0;
+		m_Size   = 0;
+		m_NoRecs = 0;
+		m_Slots.clear();
+	}
+
+	// cache line size used for aligning the columns
+	static const size_t Alignment = 64;
+
+	struct Slot {
+		DataType Type;
+		size_t   Offset;
+	};
+
+	char             *m_Buffer; // the allocated memory
+	char             *m_Block;  // the aligned start of the memory block
+	size_t            m_Size;
+	UInt              m_NoRecs;
+	std::vector<Slot> m_Slots;
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_COLUMNARENA_H_INCLUDED */
@@ -0,0 +1,189 @@
+#ifndef DCI_COLUMNDATA_H_INCLUDED
+#define DCI_COLUMNDATA_H_INCLUDED
+
+#include "DCI/DCI.h"
+
+#include <limits>
+#include <string.h>
+
+namespace DCI {
+
+// {internal}
+// Description: Column Element Type Traits.
+//
+// Maps the primitive element types of column vectors to their
+// data type and typed vector class.
+template<class T> struct ColumnType;
+
+// {internal}
+template<> struct ColumnType<Byte> {
+	typedef ByteVector VectorType;
+	static DataType GetDataType() { return DT_BYTE; }
+	static Byte     GetMissing()  { return BYTE_NAN; }
+};
+
+// {internal}
+template<> struct ColumnType<Int> {
+	typedef IntVector VectorType;
+	static DataType GetDataType() { return DT_INT; }
+	static Int      GetMissing()  { return INT_NAN; }
+};
+
+// {internal}
+template<> struct ColumnType<Double> {
+	typedef DoubleVector VectorType;
+	static DataType GetDataType() { return DT_DOUBLE; }
+	static Double   GetMissing()  { return std::numeric_limits<Double>::quiet_NaN(); }
+};
+
+// {internal}
+template<> struct ColumnType<String> {
+	typedef StringVector VectorType;
+	static DataType GetDataType() { return DT_STRING; }
+	static String   GetMissing()  { return String(); }
+};
+
+// {internal}
+// Description: Column Data Helpers.
+//
+// Helper routines giving typed access to the representation of a
+// column's value vector. Vectors returned by IVariable::GetValues
+// share their representation with the column (see VectorRepBase),
+// so reading through these helpers does not copy any data.
+class ColumnData {
+public:
+	// Description:
+	// Returns the data type of the vectors storing the values of
+	// a field with the specified data type. Date/time values are
+	// stored as doubles and enumerations as integers.
+	static DataType GetStorageType(DataType dt) {
+		switch (dt) {
+			case DT_DATETIME:    return DT_DOUBLE;
+			case DT_ENUMERATION: return DT_INT;
+			default:             return dt;
+		}
+	}
+
+	// Description:
+	// Returns the size of one element of a vector with a fixed-width
+	// data type, or 0 for complex data types (strings, values).
+	static size_t GetElementSize(DataType dt) {
+		switch (GetStorageType(dt)) {
+			case DT_BYTE:   return sizeof(Byte);
+			case DT_INT:    return sizeof(Int);
+			case DT_DOUBLE: return sizeof(Double);
+			default:        return 0;
+		}
+	}
+
+	// Description:
+	// Tests if elements of the specified data type can be copied
+	// using memcpy().
+	static Bool IsFixedWidth(DataType dt) {
+		return GetElementSize(dt) != 0;
+	}
+
+	// Description:
+	// Returns a read-only pointer to the first element of a vector.
+	//
+	// Returns:
+	// The pointer to the vector's elements, or NULL if the vector is
+	// empty or its data type does not match T.
+	template<class T> static const T *GetPtr(const Vector &v) {
+		if (!v.Len() || v.GetDataType() != ColumnType<T>::GetDataType()) return 0;
+		typename ColumnType<T>::VectorType tv(v);
+		return tv.GetPtr();
+	}
+
+	// Description:
+	// Returns the address of the first element of a vector of any
+	// data type. Two vectors sharing the same representation return
+	// the same address.
+	//
+	// Returns:
+	// The address of the vector's elements, or NULL if the vector is
+	// empty.
+	static const void *GetDataPtr(const Vector &v) {
+		if (!v.Len()) return 0;
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return GetPtr<Byte>(v);
+			case DT_INT:    return GetPtr<Int>(v);
+			case DT_DOUBLE: return GetPtr<Double>(v);
+			case DT_STRING: return StringVector(v).GetPtr();
+			case DT_VALUE:  return ValueVector(v).GetPtr();
+			default:        return 0;
+		}
+	}
+
+	// Description:
+	// Tests if a vector still shares its representation with another
+	// one, i.e. if neither of them has been modified since one was
+	// copied from the other.
+	static Bool IsSameData(const Vector &v1, const Vector &v2) {
+		return v1.GetDataType() == v2.GetDataType() && v1.Len() == v2.Len() && GetDataPtr(v1) == GetDataPtr(v2);
+	}
+
+	// Description:
+	// Redimensions a typed vector and returns a writable pointer to
+	// its first element. The representation is unshared first, so
+	// writing through the pointer never affects other vectors.
+	//
+	// Returns:
+	// The pointer to the vector's elements, or NULL if the vector is
+	// empty or could not be redimensioned.
+	template<class T> static T *Alloc(typename ColumnType<T>::VectorType &v, size_t Len) {
+		if (!v.ReDim(Len) || !Len) return 0;
+		return &v[0];
+	}
+
+	// Description:
+	// Returns an element of a byte, integer, double or string vector.
+	//
+	// Returns:
+	// The value of the element, or a void value if the index is out of
+	// range or the data type is not supported.
+	static Value GetValue(const Vector &v, size_t Index) {
+		if (Index >= v.Len()) return Value();
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return Value(GetPtr<Byte>(v)[Index]);
+			case DT_INT:    return Value(GetPtr<Int>(v)[Index]);
+			case DT_DOUBLE: return Value(GetPtr<Double>(v)[Index]);
+			case DT_STRING: return Value(StringVector(v).GetPtr()[Index]);
+			default:        return Value();
+		}
+	}
+
+	// Description:
+	// Tests if two elements are identical. Doubles are compared
+	// bitwise, so that NaN is identical to NaN (but -0.0 is not
+	// identical to 0.0).
+	template<class T> static Bool IsIdentical(const T &a, const T &b) { return a == b; }
+	static Bool IsIdentical(Double a, Double b) { return memcmp(&a, &b, sizeof(Double)) == 0; }
+
+	// Description:
+	// Tests if an element represents a missing value (NaN).
+	static Bool IsMissing(Byte b)   { return b == BYTE_NAN; }
+	static Bool IsMissing(Int i)    { return i == INT_NAN; }
+	static Bool IsMissing(Double d) { return d != d; }
+
+	// Description:
+	// Converts an element to double precision floating point,
+	// mapping missing values to NaN.
+	static Double ToDouble(Byte b)   { return IsMissing(b) ? ColumnType<Double>::GetMissing() : Double(b); }
+	static Double ToDouble(Int i)    { return IsMissing(i) ? ColumnType<Double>::GetMissing() : Double(i); }
+	static Double ToDouble(Double d) { return d; }
+};
+
+// {internal}
+// Description: String Hash Function Object.
+//
+// Hash function for using strings as keys of hashed standard containers.
+struct StringHash {
+	size_t operator () (const String &s) const {
+		return s.Hash();
+	}
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_COLUMNDATA_H_INCLUDED */
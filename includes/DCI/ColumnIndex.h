@@ -0,0 +1,306 @@
+#ifndef DCI_COLUMNINDEX_H_INCLUDED
+#define DCI_COLUMNINDEX_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Column Index Class.
+//
+// A column index is a secondary index on a column (variable) of a
+// table. It consists of a sorted permutation of the column's records,
+// used for range queries by binary search, and a hash index mapping
+// each distinct value to its records, used for equality queries.
+// Records with missing values (NaN) are not indexed.
+//
+// Both parts are built on demand by the first query needing them.
+// The index holds a reference to the column's value vector; if the
+// column is modified, the index detects this on the next query and is
+// rebuilt. Please note, that because of this second reference the first
+// write of a single value (IVariable::SetValue) after the index has been
+// built copies the column's entire vector (see VectorRepBase). Call
+// Invalidate before modifying a column value by value, or index columns
+// which are replaced as a whole (IVariable::SetValues).
+class ColumnIndex {
+public:
+	// Description:
+	// Constructs a new index. If a column is supplied, the index is
+	// attached to it.
+	//
+	// Arguments:
+	// hVariable - The column (variable) to be indexed.
+	ColumnIndex() : m_Sorted(false), m_Hashed(false) {}
+	ColumnIndex(const IVariableHandle &hVariable) : m_Sorted(false), m_Hashed(false) {
+		Attach(hVariable);
+	}
+
+	// Description:
+	// Attaches the index to a (possibly different) column.
+	//
+	// Arguments:
+	// hVariable - The column (variable) to be indexed.
+	void Attach(const IVariableHandle &hVariable) {
+		m_Variable = hVariable;
+		Invalidate();
+	}
+
+	// Description:
+	// Discards the index; it is rebuilt by the next query.
+	void Invalidate() {
+		m_Values = Vector();
+		m_Sorted = m_Hashed = false;
+		m_Order.clear();
+		m_NumKeys.clear();
+		m_StrKeys.clear();
+		m_NumHash.clear();
+		m_StrHash.clear();
+	}
+
+	// Description:
+	// Tests if the index reflects the current values of the column.
+	Bool IsCurrent() const {
+		return m_Sorted && m_Variable && ColumnData::IsSameData(m_Variable->GetValues(), m_Values);
+	}
+
+	// Description:
+	// Returns the records whose value equals a specified value
+	// (equality query using the hash index).
+	//
+	// Arguments:
+	// value - The value to be searched for.
+	//
+	// Returns:
+	// The indexes of the matching records in ascending order. The index
+	// of the first record is 1.
+	IntVector FindRecords(const Value &value) {
+		IntVector result;
+		if (!BuildHash()) return result;
+		Range range(0, 0);
+		if (m_Values.GetDataType() == DT_STRING) {
+			if (value.GetDataType() != DT_STRING) return result;
+			StrHash::const_iterator it = m_StrHash.find(value.operator String());
+			if (it != m_StrHash.end()) range = it->second;
+		} else {
+			Double d = ToDouble(value);
+			if (d != d) return result;
+			NumHash::const_iterator it = m_NumHash.find(d);
+			if (it != m_NumHash.end()) range = it->second;
+		}
+		return GetRecords(range.first, range.first + range.second, false);
+	}
+
+	// Description:
+	// Returns the records whose value lies within a specified range
+	// (range query using binary search on the sorted permutation).
+	//
+	// Arguments:
+	// lo - The lower bound of the range (inclusive).
+	// hi - The upper bound of the range (inclusive).
+	//
+	// Returns:
+	// The indexes of the matching records in ascending order. The index
+	// of the first record is 1.
+	IntVector FindRecords(const Value &lo, const Value &hi) {
+		IntVector result;
+		if (!BuildSorted()) return result;
+		size_t first, last;
+		if (m_Values.GetDataType() == DT_STRING) {
+			if (lo.GetDataType() != DT_STRING || hi.GetDataType() != DT_STRING) return result;
+			String sLo = lo.operator String(), sHi = hi.operator String();
+			first = std::lower_bound(m_StrKeys.begin(), m_StrKeys.end(), sLo) - m_StrKeys.begin();
+			last  = std::upper_bound(m_StrKeys.begin(), m_StrKeys.end(), sHi) - m_StrKeys.begin();
+		} else {
+			Double dLo = ToDouble(lo), dHi = ToDouble(hi);
+			if (dLo != dLo || dHi != dHi) return result;
+			first = std::lower_bound(m_NumKeys.begin(), m_NumKeys.end(), dLo) - m_NumKeys.begin();
+			last  = std::upper_bound(m_NumKeys.begin(), m_NumKeys.end(), dHi) - m_NumKeys.begin();
+		}
+		return GetRecords(first, last, true);
+	}
+
+	// Description:
+	// Returns the (non-missing) records of the column sorted by value
+	// in ascending order. Records with equal values keep their order.
+	//
+	// Returns:
+	// The indexes of the records. The index of the first record is 1.
+	IntVector GetSortedRecords() {
+		if (!BuildSorted()) return IntVector();
+		return GetRecords(0, m_Order.size(), false);
+	}
+
+private:
+	typedef std::pair<UInt, UInt> Range; // first position in m_Order, number of records
+	typedef std::unordered_map<Double, Range>             NumHash;
+	typedef std::unordered_map<String, Range, StringHash> StrHash;
+
+	static Double ToDouble(const Value &v) {
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return ColumnData::ToDouble((Byte)v);
+			case DT_INT:    return ColumnData::ToDouble((Int)v);
+			case DT_DOUBLE: return (Double)v;
+			default:        return ColumnType<Double>::GetMissing();
+		}
+	}
+
+	Bool BuildSorted() {
+		if (IsCurrent()) return true;
+		Invalidate();
+		if (!m_Variable) return false;
+		m_Values = m_Variable->GetValues();
+		switch (m_Values.GetDataType()) {
+			case DT_BYTE:   SortNumeric(ColumnData::GetPtr<Byte>(m_Values));   break;
+			case DT_INT:    SortNumeric(ColumnData::GetPtr<Int>(m_Values));    break;
+			case DT_DOUBLE: SortNumeric(ColumnData::GetPtr<Double>(m_Values)); break;
+			case DT_STRING: SortStrings(StringVector(m_Values));               break;
+			default:        break;
+		}
+		m_Sorted = true;
+		return true;
+	}
+
+	template<class T> void SortNumeric(const T *p) {
+		size_t n = m_Values.Len();
+		m_Order.reserve(n);
+		for (size_t i=0; i<n; i++) {
+			if (!ColumnData::IsMissing(p[i])) m_Order.push_back((UInt)i);
+		}
+		std::stable_sort(m_Order.begin(), m_Order.end(), [p](UInt a, UInt b) { return p[a] < p[b]; });
+		m_NumKeys.resize(m_Order.size());
+		for (size_t k=0; k<m_Order.size(); k++) m_NumKeys[k] = (Double)p[m_Order[k]];
+	}
+
+	void SortStrings(const StringVector &sv) {
+		const String *p = sv.Len() ? sv.GetPtr() : 0;
+		m_Order.resize(sv.Len());
+		for (size_t i=0; i<m_Order.size(); i++) m_Order[i] = (UInt)i;
+		std::stable_sort(m_Order.begin(), m_Order.end(), [p](UInt a, UInt b) { return p[a] < p[b]; });
+		m_StrKeys.resize(m_Order.size());
+		for (size_t k=0; k<m_Order.size(); k++) m_StrKeys[k] = p[m_Order[k]];
+	}
+
+	// the hash index maps each distinct value to its run in the sorted permutation
+	Bool BuildHash() {
+		if (!BuildSorted()) return false;
+		if (m_Hashed) return true;
+		if (m_Values.GetDataType() == DT_STRING) {
+			BuildHash(m_StrKeys, m_StrHash);
+		} else {
+			BuildHash(m_NumKeys, m_NumHash);
+		}
+		m_Hashed = true;
+		return true;
+	}
+	template<class K, class H> static void BuildHash(const std::vector<K> &keys, H &hash) {
+		hash.reserve(keys.size());
+		for (size_t first=0, last; first<keys.size(); first=last) {
+			for (last=first+1; last<keys.size() && keys[last] == keys[first]; last++);
+			hash[keys[first]] = Range((UInt)first, (UInt)(last - first));
+		}
+	}
+
+	// converts positions [first, last) of the sorted permutation to record indexes
+	IntVector GetRecords(size_t first, size_t last, Bool sortByRecord) const {
+		IntVector result;
+		Int *p = ColumnData::Alloc<Int>(result, last - first);
+		for (size_t k=first; k<last; k++) *p++ = (Int)m_Order[k] + 1;
+		if (sortByRecord && last > first) std::sort(&result[0], &result[0] + (last - first));
+		return result;
+	}
+
+	IVariableHandle     m_Variable;
+	Vector              m_Values;  // the column's vector the index refers to (shared, see above)
+	Bool                m_Sorted;  // the sorted permutation is built
+	Bool                m_Hashed;  // the hash index is built
+	std::vector<UInt>   m_Order;   // zero-based record positions sorted by value
+	std::vector<Double> m_NumKeys; // values in sorted order (numeric columns)
+	std::vector<String> m_StrKeys; // values in sorted order (string columns)
+	NumHash             m_NumHash;
+	StrHash             m_StrHash;
+};
+
+// {group:Data Classes}
+// Description: Table Indexes Class.
+//
+// Manages the secondary indexes (see ColumnIndex) of the columns of a
+// table. An index is created for a column the first time the column
+// is queried and is kept until it is dropped.
+//
+// Please note, that each index holds a reference to its column; drop
+// the index before removing the column from the table.
+class TableIndexes {
+public:
+	// Description:
+	// Constructs the index manager of a table.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be indexed.
+	TableIndexes(const ITableHandle &hTable) : m_Table(hTable) {}
+
+	// Description:
+	// Returns the index of a column, creating it if necessary.
+	//
+	// Arguments:
+	// colKey - Key associated with the column.
+	//
+	// Returns:
+	// The pointer to the index, or NULL if there's no column with the
+	// specified key.
+	ColumnIndex *GetIndex(const String &colKey) {
+		Indexes::iterator it = m_Indexes.find(colKey);
+		if (it != m_Indexes.end()) return &it->second;
+		IVariableHandle hCol = m_Table->GetColumn(colKey);
+		if (!hCol) return 0;
+		return &(m_Indexes[colKey] = ColumnIndex(hCol));
+	}
+
+	// Description:
+	// Drops the index of a column.
+	//
+	// Arguments:
+	// colKey - Key associated with the column.
+	void DropIndex(const String &colKey) {
+		m_Indexes.erase(colKey);
+	}
+
+	// Description:
+	// Returns the records of the table with a specified value or a
+	// value within a specified range in a column.
+	//
+	// Arguments:
+	// colKey - Key associated with the column.
+	// value  - The value to be searched for.
+	// lo     - The lower bound of the range (inclusive).
+	// hi     - The upper bound of the range (inclusive).
+	//
+	// Returns:
+	// The indexes of the matching records in ascending order. The index
+	// of the first record is 1.
+	IntVector FindRecords(const String &colKey, const Value &value) {
+		ColumnIndex *pIndex = GetIndex(colKey);
+		return pIndex ? pIndex->FindRecords(value) : IntVector();
+	}
+	IntVector FindRecords(const String &colKey, const Value &lo, const Value &hi) {
+		ColumnIndex *pIndex = GetIndex(colKey);
+		return pIndex ? pIndex->FindRecords(lo, hi) : IntVector();
+	}
+
+private:
+	typedef std::map<String, ColumnIndex> Indexes;
+
+	ITableHandle m_Table;
+	Indexes      m_Indexes;
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_COLUMNINDEX_H_INCLUDED */
@@ -0,0 +1,357 @@
+#ifndef DCI_COLUMNSTATISTICS_H_INCLUDED
+#define DCI_COLUMNSTATISTICS_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+
+#include <math.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Column Statistics Class.
+//
+// Column statistics cache the minimum, maximum, number of missing
+// values (NaN), sortedness and an estimate of the number of distinct
+// values of a column (variable). The statistics are computed in one
+// pass when they are queried for the first time and then kept up to
+// date:
+//
+// * Values written through SetValue update the statistics
+//   incrementally (only the affected statistics are invalidated).
+// * Vectors written through SetValues invalidate the statistics; they
+//   are recomputed lazily by the next query.
+// * Changes made to the column by other means (e.g. by redimensioning
+//   the table) are detected on the next query. If the column only grew
+//   or shrank, just the added or removed records are processed.
+//
+// Change detection relies on the copy-on-write sharing of value
+// vectors: the statistics hold a reference to the column's vector
+// representation, so the column has to copy it on its next write
+// unless the write is made through this class. Minimum and maximum
+// are only available for numeric columns; missing values are ignored
+// by all statistics except the NaN count and sortedness (a column
+// containing missing values is not sorted).
+class ColumnStatistics {
+public:
+	// Description:
+	// Constructs new statistics. If a column is supplied, the statistics
+	// are attached to it.
+	//
+	// Arguments:
+	// hVariable - The column (variable) to be described.
+	ColumnStatistics() {
+		Invalidate();
+	}
+	ColumnStatistics(const IVariableHandle &hVariable) {
+		Attach(hVariable);
+	}
+
+	// Description:
+	// Attaches the statistics to a (possibly different) column.
+	//
+	// Arguments:
+	// hVariable - The column (variable) to be described.
+	void Attach(const IVariableHandle &hVariable) {
+		m_Variable = hVariable;
+		m_Values   = m_Variable ? m_Variable->GetValues() : Vector();
+		Invalidate();
+	}
+
+	// Description:
+	// Discards all cached statistics; they are recomputed by the next
+	// query.
+	void Invalidate() {
+		m_HasMinMax = m_HasNaNCount = m_HasSorted = m_HasDistinct = false;
+		m_Min      = HUGE_VAL;
+		m_Max      = -HUGE_VAL;
+		m_NaNCount = 0;
+		m_Sorted   = false;
+		m_Distinct = 0;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the column's value vector the statistics refer to.
+	Vector GetValues() {
+		Refresh();
+		return m_Values;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of values of the column.
+	size_t GetLength() {
+		Refresh();
+		return m_Values.Len();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the minimum (non-missing) value of a numeric column,
+	// or NaN if there is no such value.
+	Double GetMin() {
+		Update(m_HasMinMax);
+		return m_Min <= m_Max ? m_Min : ColumnType<Double>::GetMissing();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the maximum (non-missing) value of a numeric column,
+	// or NaN if there is no such value.
+	Double GetMax() {
+		Update(m_HasMinMax);
+		return m_Min <= m_Max ? m_Max : ColumnType<Double>::GetMissing();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of missing values (NaN) of the column.
+	size_t GetNaNCount() {
+		Update(m_HasNaNCount);
+		return m_NaNCount;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Tests if the values of the column are sorted in ascending
+	// (non-decreasing) order.
+	Bool IsSorted() {
+		Update(m_HasSorted);
+		return m_Sorted;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns an estimate of the number of distinct non-missing values
+	// of the column. The estimate is based on a HyperLogLog sketch; its
+	// typical relative error is about 3%.
+	size_t GetDistinctCount() {
+		Update(m_HasDistinct);
+		return m_Distinct;
+	}
+
+	// Description:
+	// Sets the value of a field of the column and updates the
+	// statistics incrementally.
+	//
+	// Arguments:
+	// recIdx   - Index of the field. The index of the first field is 1.
+	// newValue - The new value of the field.
+	//
+	// Returns:
+	// true, if the new value is accepted, or false otherwise.
+	Bool SetValue(UInt recIdx, const Value &newValue) {
+		Refresh();
+		DataType dt = m_Values.GetDataType();
+		Bool numeric = ColumnData::IsFixedWidth(dt) && recIdx >= 1 && recIdx <= m_Values.Len();
+		Double oldVal = numeric ? GetDouble(m_Values, recIdx - 1) : 0.0;
+
+		// release the shared representation, so the column is written in place
+		m_Values = Vector();
+		Bool ok = m_Variable->SetValue(recIdx, newValue);
+		m_Values = m_Variable->GetValues();
+		if (!ok) return false;
+		if (!numeric || m_Values.GetDataType() != dt) {
+			Invalidate();
+			return true;
+		}
+
+		Double newVal = GetDouble(m_Values, recIdx - 1);
+		Bool oldNaN = oldVal != oldVal, newNaN = newVal != newVal;
+		if (m_HasNaNCount) m_NaNCount = m_NaNCount + newNaN - oldNaN;
+		if (m_HasMinMax) {
+			if (!oldNaN && (oldVal == m_Min || oldVal == m_Max) && oldVal != newVal) {
+				m_HasMinMax = false;
+			} else if (!newNaN) {
+				if (newVal < m_Min) m_Min = newVal;
+				if (newVal > m_Max) m_Max = newVal;
+			}
+		}
+		if (m_HasSorted) {
+			if (m_Sorted) {
+				size_t i = recIdx - 1;
+				m_Sorted = !newNaN &&
+					(i == 0                   || GetDouble(m_Values, i - 1) <= newVal) &&
+					(i + 1 == m_Values.Len()  || newVal <= GetDouble(m_Values, i + 1));
+			} else {
+				m_HasSorted = false;
+			}
+		}
+		m_HasDistinct = false;
+		return true;
+	}
+
+	// Description:
+	// Sets the value vector of the column. The statistics are
+	// invalidated and recomputed by the next query.
+	//
+	// Arguments:
+	// newValues - The new value vector.
+	//
+	// Returns:
+	// true, if the new value vector is accepted, or false otherwise.
+	Bool SetValues(const Vector &newValues) {
+		m_Values = Vector();
+		Bool ok = m_Variable->SetValues(newValues);
+		m_Values = m_Variable->GetValues();
+		Invalidate();
+		return ok;
+	}
+
+private:
+	// HyperLogLog precision: 2^DistinctBits registers
+	static const UInt DistinctBits = 10;
+
+	void Update(Bool &isValid) {
+		Refresh();
+		if (!isValid) Scan();
+	}
+
+	// detects changes made to the column since the statistics were
+	// computed and processes added or removed records incrementally
+	void Refresh() {
+		if (!m_Variable) return;
+		Vector current = m_Variable->GetValues();
+		if (ColumnData::IsSameData(current, m_Values)) return;
+		DataType dt = current.GetDataType();
+		size_t elemSize = ColumnData::GetElementSize(dt);
+		size_t n0 = m_Values.Len(), n1 = current.Len(), n = n0 < n1 ? n0 : n1;
+		if (!elemSize || dt != m_Values.GetDataType() || (n && memcmp(ColumnData::GetDataPtr(current), ColumnData::GetDataPtr(m_Values), n * elemSize))) {
+			Invalidate();
+		} else if (n1 > n0) {
+			Add(current, n0, n1);
+		} else {
+			Remove(m_Values, n1, n0);
+		}
+		m_Values = current;
+	}
+
+	// computes all statistics in one pass
+	void Scan() {
+		Invalidate();
+		m_HasMinMax = m_HasNaNCount = m_HasSorted = m_HasDistinct = true;
+		m_Sorted    = true;
+		m_Registers.assign((size_t)1 << DistinctBits, 0);
+		if (m_Values.GetDataType() == DT_STRING) {
+			StringVector sv(m_Values);
+			for (size_t i=0; i<sv.Len(); i++) {
+				if (i && sv[i] < sv[i-1]) m_Sorted = false;
+				AddHash(sv[i].Hash());
+			}
+			m_Distinct = EstimateDistinct();
+			return;
+		}
+		Add(m_Values, 0, m_Values.Len());
+	}
+
+	// incorporates the records [first, last) of a numeric vector
+	void Add(const Vector &v, size_t first, size_t last) {
+		switch (v.GetDataType()) {
+			case DT_BYTE:   Add(ColumnData::GetPtr<Byte>(v), first, last);   break;
+			case DT_INT:    Add(ColumnData::GetPtr<Int>(v), first, last);    break;
+			case DT_DOUBLE: Add(ColumnData::GetPtr<Double>(v), first, last); break;
+			default:        Invalidate(); break;
+		}
+	}
+	template<class T> void Add(const T *p, size_t first, size_t last) {
+		Double lo = m_Min, hi = m_Max;
+		size_t noNaN = 0;
+		Bool sorted = m_Sorted;
+		for (size_t i=first; i<last; i++) {
+			if (ColumnData::IsMissing(p[i])) {
+				noNaN++;
+				sorted = false;
+				continue;
+			}
+			Double d = (Double)p[i];
+			if (d < lo) lo = d;
+			if (d > hi) hi = d;
+			if (i && (ColumnData::IsMissing(p[i-1]) || p[i] < p[i-1])) sorted = false;
+			if (m_HasDistinct) AddHash(HashBits(d));
+		}
+		m_Min = lo;
+		m_Max = hi;
+		m_NaNCount += noNaN;
+		m_Sorted = sorted;
+		if (m_HasDistinct) m_Distinct = EstimateDistinct();
+	}
+
+	// removes the records [first, last) of a numeric vector
+	void Remove(const Vector &v, size_t first, size_t last) {
+		for (size_t i=first; i<last; i++) {
+			Double d = GetDouble(v, i);
+			if (d != d) {
+				m_NaNCount--;
+			} else if (d == m_Min || d == m_Max) {
+				m_HasMinMax = false;
+			}
+		}
+		// truncating a sorted column leaves it sorted; an unsorted column may become sorted
+		if (!m_Sorted) m_HasSorted = false;
+		m_HasDistinct = false;
+	}
+
+	static Double GetDouble(const Vector &v, size_t i) {
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return ColumnData::ToDouble(ColumnData::GetPtr<Byte>(v)[i]);
+			case DT_INT:    return ColumnData::ToDouble(ColumnData::GetPtr<Int>(v)[i]);
+			case DT_DOUBLE: return ColumnData::GetPtr<Double>(v)[i];
+			default:        return ColumnType<Double>::GetMissing();
+		}
+	}
+
+	static unsigned long long HashBits(Double d) {
+		if (d == 0.0) d = 0.0; // -0.0 and 0.0 are the same value
+		unsigned long long h;
+		memcpy(&h, &d, sizeof(h));
+		return h;
+	}
+
+	void AddHash(unsigned long long h) {
+		// mix the bits (splitmix64 finalizer), then update the register
+		h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+		h ^= h >> 31;
+		size_t idx = (size_t)(h >> (64 - DistinctBits));
+		unsigned long long w = h << DistinctBits;
+		unsigned char rank = 1;
+		while (rank <= 64 - DistinctBits && !(w & 0x8000000000000000ULL)) {
+			w <<= 1;
+			rank++;
+		}
+		if (rank > m_Registers[idx]) m_Registers[idx] = rank;
+	}
+
+	size_t EstimateDistinct() const {
+		const Double m = (Double)m_Registers.size();
+		Double sum = 0.0;
+		size_t zeros = 0;
+		for (size_t i=0; i<m_Registers.size(); i++) {
+			sum += ldexp(1.0, -(int)m_Registers[i]);
+			if (!m_Registers[i]) zeros++;
+		}
+		Double e = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+		if (e <= 2.5 * m && zeros) e = m * log(m / zeros);
+		return (size_t)(e + 0.5);
+	}
+
+	IVariableHandle            m_Variable;
+	Vector                     m_Values;    // the column's vector the statistics refer to
+	Bool                       m_HasMinMax;
+	Bool                       m_HasNaNCount;
+	Bool                       m_HasSorted;
+	Bool                       m_HasDistinct;
+	Double                     m_Min;
+	Double                     m_Max;
+	size_t                     m_NaNCount;
+	Bool                       m_Sorted;
+	size_t                     m_Distinct;
+	std::vector<unsigned char> m_Registers; // HyperLogLog sketch
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_COLUMNSTATISTICS_H_INCLUDED */
@@ -0,0 +1,330 @@
+#ifndef DCI_COLUMNVALIDATOR_H_INCLUDED
+#define DCI_COLUMNVALIDATOR_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+#include "DCI/ColumnStatistics.h"
+
+#include <math.h>
+#include <unordered_set>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+  // {secret}
+  #define DCI_COLUMNVALIDATOR_SSE2
+  #include <emmintrin.h>
+#endif
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Column Validator Class.
+//
+// A column validator is a diagnostic: it locates the first value of a
+// vector violating the constraints of a field definition (minimum
+// value, maximum value and allowed values), e.g. in order to report
+// why IVariable::SetValues rejected the vector. The constraints are
+// read from the field definition once; range checks then run
+// block-wise using SIMD instructions where available, and allowed
+// values are looked up in a hash set instead of being compared one by
+// one.
+//
+// The rules are those documented for field definitions and may differ
+// from the library's own check in details: missing values (NaN) always
+// pass, and the integer values of an enumeration are valid, if they are
+// a valid index into the list of its allowed values. A value found is
+// thus a likely, not a certain, reason for a rejection.
+//
+// The validator does not replace the library's check: SetValues still
+// validates every value. Writing a column without that check would
+// require a change to the library itself.
+//
+// Please note, that the validator takes a snapshot of the constraints;
+// call Attach again after the field definition has changed.
+class ColumnValidator {
+public:
+	// Description:
+	// Constructs a new validator. If a field definition is supplied,
+	// the validator is attached to it.
+	//
+	// Arguments:
+	// hFieldDef - The field definition providing the constraints.
+	ColumnValidator() {
+		Reset();
+	}
+	ColumnValidator(const IFieldDefHandle &hFieldDef) {
+		Attach(hFieldDef);
+	}
+
+	// Description:
+	// Reads the constraints of a field definition.
+	//
+	// Arguments:
+	// hFieldDef - The field definition providing the constraints.
+	void Attach(const IFieldDefHandle &hFieldDef) {
+		Reset();
+		if (!hFieldDef) return;
+		m_FieldDataType = hFieldDef->GetDataType();
+		m_DataType      = ColumnData::GetStorageType(m_FieldDataType);
+		m_MinValue      = hFieldDef->GetMinValue();
+		m_MaxValue      = hFieldDef->GetMaxValue();
+		m_HasMin        = m_MinValue.GetDataType() != DT_VOID;
+		m_HasMax        = m_MaxValue.GetDataType() != DT_VOID;
+		if (m_HasMin) m_DblMin = ToDouble(m_MinValue);
+		if (m_HasMax) m_DblMax = ToDouble(m_MaxValue);
+		m_IntMin = m_HasMin ? ToIntBound(ceil(m_DblMin))  : INT_NAN + 1;
+		m_IntMax = m_HasMax ? ToIntBound(floor(m_DblMax)) : INT_INF;
+		Vector allowed = hFieldDef->GetAllowedValues();
+		m_NoAllowed = allowed.Len();
+		if (!m_NoAllowed || m_FieldDataType == DT_ENUMERATION) return;
+		switch (m_DataType) {
+			case DT_BYTE:
+			case DT_INT:    InsertAll(allowed, m_AllowedInts);    break;
+			case DT_DOUBLE: InsertAll(allowed, m_AllowedDoubles); break;
+			case DT_STRING: InsertAll(allowed, m_AllowedStrings); break;
+			default:        break;
+		}
+	}
+
+	// Description:
+	// Locates the first value of a vector violating the constraints.
+	//
+	// Arguments:
+	// values - The vector to be searched.
+	// badIdx - Receives the (zero-based) position of the first value
+	//          violating the constraints, or 0 if the data type of the
+	//          vector does not match the storage data type of the field.
+	//
+	// Returns:
+	// true if a violation was found, or false otherwise.
+	Bool FindFirstInvalid(const Vector &values, size_t &badIdx) const {
+		badIdx = 0;
+		if (!values.Len()) return false;
+		if (values.GetDataType() != m_DataType) return true;
+		switch (m_DataType) {
+			case DT_BYTE:   return !CheckRange(ColumnData::GetPtr<Byte>(values), values.Len(), badIdx)   || !CheckAllowed(ColumnData::GetPtr<Byte>(values), values.Len(), m_AllowedInts, badIdx);
+			case DT_INT:    return !CheckRange(ColumnData::GetPtr<Int>(values), values.Len(), badIdx)    || !CheckAllowed(ColumnData::GetPtr<Int>(values), values.Len(), m_AllowedInts, badIdx);
+			case DT_DOUBLE: return !CheckRange(ColumnData::GetPtr<Double>(values), values.Len(), badIdx) || !CheckAllowed(ColumnData::GetPtr<Double>(values), values.Len(), m_AllowedDoubles, badIdx);
+			case DT_STRING: return !CheckStrings(StringVector(values), badIdx);
+			default:        return false;
+		}
+	}
+
+	// Description:
+	// Locates the first value of a column violating the constraints
+	// using the column's statistics. If the cached minimum and maximum
+	// are within the allowed range, the range check does not scan the
+	// values; the values are only scanned if allowed values have to be
+	// checked or if the range is violated (to locate the violation).
+	//
+	// Arguments:
+	// stats  - The statistics of the column to be searched.
+	// badIdx - Receives the (zero-based) position of the first value
+	//          violating the constraints (see above).
+	//
+	// Returns:
+	// true if a violation was found, or false otherwise.
+	Bool FindFirstInvalid(ColumnStatistics &stats, size_t &badIdx) const {
+		Vector values = stats.GetValues();
+		badIdx = 0;
+		if (!values.Len()) return false;
+		if (values.GetDataType() != m_DataType) return true;
+		if (m_DataType == DT_STRING || !IsInRange(stats.GetMin(), stats.GetMax())) return FindFirstInvalid(values, badIdx);
+		switch (m_DataType) {
+			case DT_BYTE:   return !CheckAllowed(ColumnData::GetPtr<Byte>(values), values.Len(), m_AllowedInts, badIdx);
+			case DT_INT:    return !CheckAllowed(ColumnData::GetPtr<Int>(values), values.Len(), m_AllowedInts, badIdx);
+			case DT_DOUBLE: return !CheckAllowed(ColumnData::GetPtr<Double>(values), values.Len(), m_AllowedDoubles, badIdx);
+			default:        return false;
+		}
+	}
+
+private:
+	// number of elements checked per SIMD block before testing for violations
+	static const size_t BlockSize = 1024;
+
+	typedef std::unordered_set<Int>    IntSet;
+	typedef std::unordered_set<Double> DoubleSet;
+	typedef std::unordered_set<String, StringHash> StringSet;
+
+	void Reset() {
+		m_FieldDataType = m_DataType = DT_VOID;
+		m_HasMin = m_HasMax = false;
+		m_DblMin = m_DblMax = 0.0;
+		m_IntMin = INT_NAN + 1;
+		m_IntMax = INT_INF;
+		m_MinValue = m_MaxValue = Value();
+		m_NoAllowed = 0;
+		m_AllowedInts.clear();
+		m_AllowedDoubles.clear();
+		m_AllowedStrings.clear();
+	}
+
+	static Double ToDouble(const Value &v) {
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return (Byte)v;
+			case DT_INT:    return (Int)v;
+			case DT_DOUBLE: return (Double)v;
+			default:        return 0.0;
+		}
+	}
+
+	static Int ToIntBound(Double d) {
+		if (d <= (Double)(INT_NAN + 1)) return INT_NAN + 1;
+		if (d >= (Double)INT_INF)       return INT_INF;
+		return (Int)d;
+	}
+
+	template<class S> static void InsertAll(const Vector &v, S &set) {
+		switch (v.GetDataType()) {
+			case DT_BYTE:   InsertAll(ColumnData::GetPtr<Byte>(v), v.Len(), set);   break;
+			case DT_INT:    InsertAll(ColumnData::GetPtr<Int>(v), v.Len(), set);    break;
+			case DT_DOUBLE: InsertAll(ColumnData::GetPtr<Double>(v), v.Len(), set); break;
+			default:        break;
+		}
+	}
+	static void InsertAll(const Vector &v, StringSet &set) {
+		StringVector sv(v);
+		for (size_t i=0; i<sv.Len(); i++) set.insert(sv[i]);
+	}
+	template<class T, class S> static void InsertAll(const T *p, size_t Len, S &set) {
+		for (size_t i=0; i<Len; i++) set.insert(p[i]);
+	}
+
+	// tests if the range [lo, hi] of the non-missing values (NaN if there
+	// are none) satisfies the minimum and maximum value constraints
+	Bool IsInRange(Double lo, Double hi) const {
+		if (lo != lo || hi != hi) return true;
+		if (m_FieldDataType == DT_ENUMERATION) return !m_NoAllowed || (lo >= 0.0 && hi < (Double)m_NoAllowed);
+		if (m_DataType == DT_DOUBLE) return !IsOutOfRange(lo) && !IsOutOfRange(hi);
+		return lo >= (Double)m_IntMin && hi <= (Double)m_IntMax;
+	}
+
+	// scalar range checks, also used to locate a violation within a block
+	Bool CheckRange(const Byte *p, size_t Len, size_t &badIdx) const {
+		for (size_t i=0; i<Len; i++) {
+			if (IsOutOfRange(p[i])) { badIdx = i; return false; }
+		}
+		return true;
+	}
+	Bool IsOutOfRange(Byte b) const {
+		if (m_FieldDataType == DT_ENUMERATION) return false;
+		return b != BYTE_NAN && (b < m_IntMin || b > m_IntMax);
+	}
+	Bool IsOutOfRange(Double d) const {
+		return (m_HasMin && d < m_DblMin) || (m_HasMax && d > m_DblMax);
+	}
+
+	Bool CheckRange(const Int *p, size_t Len, size_t &badIdx) const {
+		Int lo = m_IntMin, hi = m_IntMax;
+		if (m_FieldDataType == DT_ENUMERATION) {
+			if (!m_NoAllowed) return true;
+			lo = 0;
+			hi = (Int)(m_NoAllowed - 1);
+		} else if (!m_HasMin && !m_HasMax) {
+			return true;
+		}
+		for (size_t first=0; first<Len; first+=BlockSize) {
+			size_t n = (Len - first < BlockSize) ? Len - first : BlockSize;
+			if (!BlockInRange(p + first, n, lo, hi)) {
+				for (size_t i=first; i<first+n; i++) {
+					if (p[i] != INT_NAN && (p[i] < lo || p[i] > hi)) { badIdx = i; return false; }
+				}
+			}
+		}
+		return true;
+	}
+
+	Bool CheckRange(const Double *p, size_t Len, size_t &badIdx) const {
+		if (!m_HasMin && !m_HasMax) return true;
+		for (size_t first=0; first<Len; first+=BlockSize) {
+			size_t n = (Len - first < BlockSize) ? Len - first : BlockSize;
+			if (!BlockInRange(p + first, n)) {
+				for (size_t i=first; i<first+n; i++) {
+					if (IsOutOfRange(p[i])) { badIdx = i; return false; }
+				}
+			}
+		}
+		return true;
+	}
+
+	// block kernels: test a block for any violation without locating it
+	static Bool BlockInRange(const Int *p, size_t n, Int lo, Int hi) {
+		size_t i = 0;
+#ifdef DCI_COLUMNVALIDATOR_SSE2
+		__m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi), vnan = _mm_set1_epi32(INT_NAN);
+		__m128i bad = _mm_setzero_si128();
+		for (; i + 4 <= n; i += 4) {
+			__m128i x   = _mm_loadu_si128((const __m128i *)(p + i));
+			__m128i out = _mm_or_si128(_mm_cmplt_epi32(x, vlo), _mm_cmpgt_epi32(x, vhi));
+			bad = _mm_or_si128(bad, _mm_andnot_si128(_mm_cmpeq_epi32(x, vnan), out));
+		}
+		if (_mm_movemask_epi8(bad)) return false;
+#endif
+		Int bad1 = 0;
+		for (; i < n; i++) bad1 |= (p[i] != INT_NAN) & ((p[i] < lo) | (p[i] > hi));
+		return !bad1;
+	}
+
+	Bool BlockInRange(const Double *p, size_t n) const {
+		Double lo = m_HasMin ? m_DblMin : -std::numeric_limits<Double>::infinity();
+		Double hi = m_HasMax ? m_DblMax : std::numeric_limits<Double>::infinity();
+		if (m_HasMin && m_DblMin != m_DblMin) return true; // NaN bound constrains nothing
+		if (m_HasMax && m_DblMax != m_DblMax) return true;
+		size_t i = 0;
+		Int bad1 = 0;
+#ifdef DCI_COLUMNVALIDATOR_SSE2
+		__m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+		__m128d bad = _mm_setzero_pd();
+		for (; i + 2 <= n; i += 2) {
+			__m128d x = _mm_loadu_pd(p + i);
+			bad = _mm_or_pd(bad, _mm_or_pd(_mm_cmplt_pd(x, vlo), _mm_cmpgt_pd(x, vhi)));
+		}
+		bad1 = _mm_movemask_pd(bad);
+#endif
+		for (; i < n; i++) bad1 |= (p[i] < lo) | (p[i] > hi);
+		return !bad1;
+	}
+
+	template<class T, class S> Bool CheckAllowed(const T *p, size_t Len, const S &set, size_t &badIdx) const {
+		if (set.empty()) return true;
+		for (size_t i=0; i<Len; i++) {
+			if (!ColumnData::IsMissing(p[i]) && set.find(p[i]) == set.end()) { badIdx = i; return false; }
+		}
+		return true;
+	}
+
+	Bool CheckStrings(const StringVector &sv, size_t &badIdx) const {
+		Bool hasMin = m_MinValue.GetDataType() == DT_STRING, hasMax = m_MaxValue.GetDataType() == DT_STRING;
+		String sMin, sMax;
+		if (hasMin) sMin = m_MinValue.operator String();
+		if (hasMax) sMax = m_MaxValue.operator String();
+		for (size_t i=0; i<sv.Len(); i++) {
+			const String &s = sv[i];
+			if ((hasMin && s < sMin) || (hasMax && s > sMax) ||
+				(!m_AllowedStrings.empty() && m_AllowedStrings.find(s) == m_AllowedStrings.end())) {
+				badIdx = i;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	DataType  m_FieldDataType; // the data type of the field definition
+	DataType  m_DataType;      // the data type of the vectors storing the values
+	Value     m_MinValue;
+	Value     m_MaxValue;
+	Bool      m_HasMin;
+	Bool      m_HasMax;
+	Double    m_DblMin;
+	Double    m_DblMax;
+	Int       m_IntMin;
+	Int       m_IntMax;
+	size_t    m_NoAllowed;
+	IntSet    m_AllowedInts;
+	DoubleSet m_AllowedDoubles;
+	StringSet m_AllowedStrings;
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_COLUMNVALIDATOR_H_INCLUDED */
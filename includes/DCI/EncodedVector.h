@@ -0,0 +1,914 @@
+#ifndef DCI_ENCODEDVECTOR_H_INCLUDED
+#define DCI_ENCODEDVECTOR_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+#include "DCI/SparseVector.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Delta Vector Class.
+//
+// A delta vector stores an integer or double vector using delta-of-delta
+// encoding, which suits monotonic columns such as time grids or record
+// IDs: the difference between consecutive differences is 0 for evenly
+// spaced values and small otherwise. Doubles are encoded through their
+// 64-bit patterns, so the encoding is lossless for all values
+// (including NaN).
+//
+// The elements are split into blocks of BlockSize elements. Every block
+// starts with a checkpoint (its first value and first difference), and
+// stores its remaining delta-of-deltas with a fixed width of 0, 1, 2, 4
+// or 8 bytes, chosen per block. Thus, unpacking a block is a branch-free
+// loop, and accessing an element decodes at most one block. Elements
+// are indexed from 0, as with Vector.
+class DeltaVector {
+public:
+	enum {
+		BlockSize = 128 // number of elements per block (checkpoint interval)
+	};
+
+	// Description:
+	// Constructs a delta vector.
+	//
+	// Arguments:
+	// v  - The (plain) integer or double vector to be represented.
+	// fp - The file pointer of a file storing a delta vector (see
+	//      SaveToBinaryFile).
+	DeltaVector() : m_Type(DT_VOID), m_Len(0) {}
+	DeltaVector(const Vector &v) : m_Type(DT_VOID), m_Len(0) {
+		Assign(v);
+	}
+	DeltaVector(FILE *fp) : m_Type(DT_VOID), m_Len(0) {
+		LoadFromBinaryFile(fp);
+	}
+
+	// Description:
+	// Tests if vectors of a data type can be delta encoded.
+	static Bool CanEncode(DataType dt) {
+		return dt == DT_INT || dt == DT_DOUBLE;
+	}
+
+	// Description:
+	// Builds the delta encoding of a vector.
+	//
+	// Returns:
+	// true if the method succeeds, or false if the data type of the
+	// vector is not supported.
+	Bool Assign(const Vector &v) {
+		m_Type = v.Len() ? v.GetDataType() : DT_VOID;
+		m_Len  = v.Len();
+		m_Blocks.clear();
+		m_Data.clear();
+		switch (m_Type) {
+			case DT_VOID:   return true;
+			case DT_INT:    Encode(ColumnData::GetPtr<Int>(v)); return true;
+			case DT_DOUBLE: Encode(ColumnData::GetPtr<Double>(v)); return true;
+			default:
+				m_Type = DT_VOID;
+				m_Len  = 0;
+				return false;
+		}
+	}
+
+	// Description:
+	// Converts the delta vector to a plain vector.
+	Vector ToVector() const {
+		switch (m_Type) {
+			case DT_INT:    return ToVectorTyped<Int>();
+			case DT_DOUBLE: return ToVectorTyped<Double>();
+			default:        return Vector();
+		}
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the length of the (plain) vector.
+	size_t Len() const {
+		return m_Len;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the data type of the elements.
+	DataType GetDataType() const {
+		return m_Type;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the size of the encoded data in bytes.
+	size_t GetSize() const {
+		return m_Blocks.size() * sizeof(Block) + m_Data.size();
+	}
+
+	// Description:
+	// Returns an element.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	//
+	// Returns:
+	// The value of the element, or a void value if the index is out of
+	// range.
+	Value GetValue(size_t Index) const {
+		if (Index >= m_Len) return Value();
+		unsigned long long bits[BlockSize];
+		DecodeBlock(Index / BlockSize, bits);
+		unsigned long long u = bits[Index % BlockSize];
+		if (m_Type == DT_INT) {
+			Int i;
+			FromBits(u, i);
+			return Value(i);
+		}
+		Double d;
+		FromBits(u, d);
+		return Value(d);
+	}
+
+	// Description:
+	// Returns the size in bytes a vector would have when delta encoded,
+	// without encoding it.
+	//
+	// Returns:
+	// The size, or 0 if the vector can not be delta encoded.
+	static size_t GetEncodedSize(const Vector &v) {
+		switch (v.Len() ? v.GetDataType() : DT_VOID) {
+			case DT_INT:    return GetEncodedSize(ColumnData::GetPtr<Int>(v), v.Len());
+			case DT_DOUBLE: return GetEncodedSize(ColumnData::GetPtr<Double>(v), v.Len());
+			default:        return 0;
+		}
+	}
+
+	// Description:
+	// Saves the delta vector to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		Int type = m_Type;
+		unsigned long long len = m_Len, size = m_Data.size();
+		if (fwrite(&type, sizeof(type), 1, fp) != 1 || fwrite(&len, sizeof(len), 1, fp) != 1 ||
+			fwrite(&size, sizeof(size), 1, fp) != 1) return false;
+		if (!m_Blocks.empty() && fwrite(&m_Blocks[0], sizeof(Block), m_Blocks.size(), fp) != m_Blocks.size()) return false;
+		return m_Data.empty() || fwrite(&m_Data[0], 1, m_Data.size(), fp) == m_Data.size();
+	}
+
+	// Description:
+	// Loads a delta vector from a binary file written by
+	// SaveToBinaryFile.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		Int type;
+		unsigned long long len, size;
+		Assign(Vector());
+		if (fread(&type, sizeof(type), 1, fp) != 1 || fread(&len, sizeof(len), 1, fp) != 1 ||
+			fread(&size, sizeof(size), 1, fp) != 1) return false;
+		// check the sizes before allocating, as they may be corrupt
+		if ((len ? !CanEncode((DataType)type) : type != DT_VOID) || !IsValidSize(len, size, BinaryReader::GetRemaining(fp))) return false;
+		m_Blocks.resize((size_t)GetBlockCount(len));
+		m_Data.resize((size_t)size);
+		if ((!m_Blocks.empty() && fread(&m_Blocks[0], sizeof(Block), m_Blocks.size(), fp) != m_Blocks.size()) ||
+			(!m_Data.empty() && fread(&m_Data[0], 1, m_Data.size(), fp) != m_Data.size())) {
+			Assign(Vector());
+			return false;
+		}
+		m_Type = (DataType)type;
+		m_Len  = (size_t)len;
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Appends the delta vector to a buffer, e.g. in order to store it in
+	// a table file (see TableFile).
+	//
+	// Arguments:
+	// w - The writer appending to the buffer.
+	void SaveToBuffer(BinaryWriter &w) const {
+		w.Put((Int)m_Type);
+		w.Put((unsigned long long)m_Len);
+		w.Put((unsigned long long)m_Data.size());
+		if (!m_Blocks.empty()) w.Put(&m_Blocks[0], m_Blocks.size() * sizeof(Block));
+		if (!m_Data.empty()) w.Put(&m_Data[0], m_Data.size());
+	}
+
+	// Description:
+	// Loads a delta vector from a buffer written by SaveToBuffer.
+	//
+	// Arguments:
+	// r - The reader of the buffer.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBuffer(BinaryReader &r) {
+		Int type;
+		unsigned long long len, size;
+		Assign(Vector());
+		if (!r.Get(type) || !r.Get(len) || !r.Get(size)) return false;
+		// check the sizes before allocating, as they may be corrupt
+		if ((len ? !CanEncode((DataType)type) : type != DT_VOID) || !IsValidSize(len, size, r.GetRemaining())) return false;
+		m_Blocks.resize((size_t)GetBlockCount(len));
+		m_Data.resize((size_t)size);
+		if (!m_Blocks.empty()) r.Get(&m_Blocks[0], m_Blocks.size() * sizeof(Block));
+		if (!m_Data.empty()) r.Get(&m_Data[0], m_Data.size());
+		m_Type = (DataType)type;
+		m_Len  = (size_t)len;
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+private:
+	// {internal}
+	// Description:
+	// Checkpoint of a block.
+	struct Block {
+		unsigned long long First;  // bit pattern of the first element
+		unsigned long long Delta;  // difference between the first two elements
+		unsigned long long Offset; // offset of the delta-of-deltas in m_Data
+		unsigned long long Width;  // width of the delta-of-deltas in bytes (0, 1, 2, 4 or 8)
+	};
+
+	static unsigned long long GetBlockCount(unsigned long long len) {
+		return len / BlockSize + (len % BlockSize != 0);
+	}
+
+	// checks the length and the size of the delta-of-deltas read from a
+	// file or buffer against the number of bytes left in it
+	static Bool IsValidSize(unsigned long long len, unsigned long long size, unsigned long long remaining) {
+		unsigned long long noBlocks = GetBlockCount(len);
+		return noBlocks <= remaining / sizeof(Block) && size <= remaining - noBlocks * sizeof(Block) &&
+			size <= len * sizeof(unsigned long long);
+	}
+
+	static unsigned long long ToBits(Int i) { return (unsigned long long)(long long)i; }
+	static unsigned long long ToBits(Double d) {
+		unsigned long long u;
+		memcpy(&u, &d, sizeof(u));
+		return u;
+	}
+	static void FromBits(unsigned long long u, Int &i) { i = (Int)(long long)u; }
+	static void FromBits(unsigned long long u, Double &d) { memcpy(&d, &u, sizeof(d)); }
+
+	// maps small negative and positive numbers to small unsigned numbers
+	static unsigned long long ZigZag(unsigned long long u)   { return (u << 1) ^ (0 - (u >> 63)); }
+	static unsigned long long UnZigZag(unsigned long long z) { return (z >> 1) ^ (0 - (z & 1)); }
+
+	static UInt GetWidth(unsigned long long z) {
+		if (!z) return 0;
+		if (z <= 0xffULL) return 1;
+		if (z <= 0xffffULL) return 2;
+		if (z <= 0xffffffffULL) return 4;
+		return 8;
+	}
+
+	// returns the width of the delta-of-deltas of the block starting at element first
+	template<class T> static UInt GetBlockWidth(const T *p, size_t first, size_t n) {
+		UInt width = 0;
+		for (size_t i=first+2; i<first+n; i++) {
+			unsigned long long dod = (ToBits(p[i]) - ToBits(p[i-1])) - (ToBits(p[i-1]) - ToBits(p[i-2]));
+			UInt w = GetWidth(ZigZag(dod));
+			if (w > width) width = w;
+		}
+		return width;
+	}
+
+	template<class T> static size_t GetEncodedSize(const T *p, size_t Len) {
+		size_t size = 0;
+		for (size_t first=0; first<Len; first+=BlockSize) {
+			size_t n = std::min<size_t>(BlockSize, Len - first);
+			size += sizeof(Block) + (n > 2 ? (n - 2) * GetBlockWidth(p, first, n) : 0);
+		}
+		return size;
+	}
+
+	template<class U> static void Pack(unsigned char *p, unsigned long long z) {
+		U u = (U)z;
+		memcpy(p, &u, sizeof(U));
+	}
+	template<class U> static void Unpack(const unsigned char *p, unsigned long long *pOut, size_t n) {
+		for (size_t k=0; k<n; k++) {
+			U u;
+			memcpy(&u, p + k * sizeof(U), sizeof(U));
+			pOut[k] = u;
+		}
+	}
+
+	template<class T> void Encode(const T *p) {
+		m_Blocks.resize((m_Len + BlockSize - 1) / BlockSize);
+		for (size_t b=0; b<m_Blocks.size(); b++) {
+			size_t first = b * BlockSize;
+			size_t n = GetBlockLen(b);
+			Block &block = m_Blocks[b];
+			block.First  = ToBits(p[first]);
+			block.Delta  = n > 1 ? ToBits(p[first+1]) - block.First : 0;
+			block.Offset = m_Data.size();
+			block.Width  = GetBlockWidth(p, first, n);
+			if (!block.Width || n <= 2) continue;
+			m_Data.resize(m_Data.size() + (n - 2) * block.Width);
+			unsigned char *pData = &m_Data[block.Offset];
+			for (size_t i=first+2; i<first+n; i++, pData+=block.Width) {
+				unsigned long long z = ZigZag((ToBits(p[i]) - ToBits(p[i-1])) - (ToBits(p[i-1]) - ToBits(p[i-2])));
+				switch (block.Width) {
+					case 1:  Pack<unsigned char>(pData, z); break;
+					case 2:  Pack<unsigned short>(pData, z); break;
+					case 4:  Pack<UInt>(pData, z); break;
+					default: Pack<unsigned long long>(pData, z); break;
+				}
+			}
+		}
+	}
+
+	size_t GetBlockLen(size_t b) const {
+		return std::min<size_t>(BlockSize, m_Len - b * BlockSize);
+	}
+
+	// decodes the bit patterns of the elements of a block
+	void DecodeBlock(size_t b, unsigned long long *pOut) const {
+		const Block &block = m_Blocks[b];
+		size_t n = GetBlockLen(b);
+		pOut[0] = block.First;
+		if (n < 2) return;
+		size_t m = n - 2;
+		const unsigned char *pData = block.Width ? &m_Data[block.Offset] : 0;
+		switch (block.Width) {
+			case 0:  std::fill(pOut + 2, pOut + n, 0ULL); break;
+			case 1:  Unpack<unsigned char>(pData, pOut + 2, m); break;
+			case 2:  Unpack<unsigned short>(pData, pOut + 2, m); break;
+			case 4:  Unpack<UInt>(pData, pOut + 2, m); break;
+			default: Unpack<unsigned long long>(pData, pOut + 2, m); break;
+		}
+		unsigned long long delta = block.Delta;
+		pOut[1] = block.First + delta;
+		for (size_t k=2; k<n; k++) {
+			delta += UnZigZag(pOut[k]);
+			pOut[k] = pOut[k-1] + delta;
+		}
+	}
+
+	template<class T> Vector ToVectorTyped() const {
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, m_Len);
+		if (!p) return v;
+		unsigned long long bits[BlockSize];
+		for (size_t b=0; b<m_Blocks.size(); b++) {
+			size_t n = GetBlockLen(b);
+			DecodeBlock(b, bits);
+			T *pBlock = p + b * BlockSize;
+			for (size_t k=0; k<n; k++) FromBits(bits[k], pBlock[k]);
+		}
+		return v;
+	}
+
+	// checks the consistency of a loaded delta vector
+	Bool IsValid() const {
+		for (size_t b=0; b<m_Blocks.size(); b++) {
+			const Block &block = m_Blocks[b];
+			size_t n = GetBlockLen(b);
+			if (block.Width != 0 && block.Width != 1 && block.Width != 2 && block.Width != 4 && block.Width != 8) return false;
+			if (block.Width && n > 2 && (block.Offset > m_Data.size() || (n - 2) * block.Width > m_Data.size() - block.Offset)) return false;
+		}
+		return true;
+	}
+
+	DataType                   m_Type;   // data type of the elements
+	size_t                     m_Len;    // length of the plain vector
+	std::vector<Block>         m_Blocks; // checkpoint of every block
+	std::vector<unsigned char> m_Data;   // delta-of-deltas of all blocks
+};
+
+// {group:Data Classes}
+// Description: Run-Length Vector Class.
+//
+// A run-length vector stores a vector as runs of identical elements,
+// which suits columns with long runs of repeats such as individual or
+// group IDs. Every run is stored as its value and the cumulative end
+// of the run, i.e. the index of the element following it; the ends
+// form the checkpoint index used by binary search to access an
+// element. Byte, integer, double and string vectors are supported;
+// doubles are compared bitwise. Elements are indexed from 0, as with
+// Vector.
+class RunLengthVector {
+public:
+	// Description:
+	// Constructs a run-length vector.
+	//
+	// Arguments:
+	// v  - The (plain) vector to be represented.
+	// fp - The file pointer of a file storing a run-length vector (see
+	//      SaveToBinaryFile).
+	RunLengthVector() : m_Type(DT_VOID) {}
+	RunLengthVector(const Vector &v) : m_Type(DT_VOID) {
+		Assign(v);
+	}
+	RunLengthVector(FILE *fp) : m_Type(DT_VOID) {
+		LoadFromBinaryFile(fp);
+	}
+
+	// Description:
+	// Builds the run-length encoding of a vector.
+	//
+	// Returns:
+	// true if the method succeeds, or false if the data type of the
+	// vector is not supported.
+	Bool Assign(const Vector &v) {
+		m_Type = v.Len() ? v.GetDataType() : DT_VOID;
+		m_Ends = IntVector();
+		m_Values = Vector();
+		switch (m_Type) {
+			case DT_VOID:   return true;
+			case DT_BYTE:   return AssignTyped<Byte>(v);
+			case DT_INT:    return AssignTyped<Int>(v);
+			case DT_DOUBLE: return AssignTyped<Double>(v);
+			case DT_STRING: return AssignTyped<String>(v);
+			default:
+				m_Type = DT_VOID;
+				return false;
+		}
+	}
+
+	// Description:
+	// Converts the run-length vector to a plain vector.
+	Vector ToVector() const {
+		switch (m_Type) {
+			case DT_BYTE:   return ToVectorTyped<Byte>();
+			case DT_INT:    return ToVectorTyped<Int>();
+			case DT_DOUBLE: return ToVectorTyped<Double>();
+			case DT_STRING: return ToVectorTyped<String>();
+			default:        return Vector();
+		}
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the length of the (plain) vector.
+	size_t Len() const {
+		size_t n = m_Ends.Len();
+		return n ? (size_t)m_Ends.GetPtr()[n-1] : 0;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the data type of the elements.
+	DataType GetDataType() const {
+		return m_Type;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of runs.
+	size_t GetRunCount() const {
+		return m_Ends.Len();
+	}
+
+	// Description:
+	// Returns an element.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	//
+	// Returns:
+	// The value of the element, or a void value if the index is out of
+	// range.
+	Value GetValue(size_t Index) const {
+		if (Index >= Len()) return Value();
+		const Int *pEnds = m_Ends.GetPtr();
+		const Int *p = std::upper_bound(pEnds, pEnds + m_Ends.Len(), (Int)Index);
+		return ColumnData::GetValue(m_Values, p - pEnds);
+	}
+
+	// Description:
+	// Returns the number of runs of a vector, or 0 if the data type of
+	// the vector is not supported.
+	static size_t CountRuns(const Vector &v) {
+		switch (v.Len() ? v.GetDataType() : DT_VOID) {
+			case DT_BYTE:   return CountRuns(ColumnData::GetPtr<Byte>(v), v.Len());
+			case DT_INT:    return CountRuns(ColumnData::GetPtr<Int>(v), v.Len());
+			case DT_DOUBLE: return CountRuns(ColumnData::GetPtr<Double>(v), v.Len());
+			case DT_STRING: return CountRuns(StringVector(v).GetPtr(), v.Len());
+			default:        return 0;
+		}
+	}
+
+	// Description:
+	// Saves the run-length vector to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		Int type = m_Type;
+		return fwrite(&type, sizeof(type), 1, fp) == 1 && m_Ends.SaveToBinaryFile(fp) && m_Values.SaveToBinaryFile(fp);
+	}
+
+	// Description:
+	// Loads a run-length vector from a binary file written by
+	// SaveToBinaryFile.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		Int type;
+		if (fread(&type, sizeof(type), 1, fp) != 1) return false;
+		m_Type   = (DataType)type;
+		Vector ends(fp);
+		m_Values = Vector(fp);
+		if (ferror(fp) || (ends.Len() && ends.GetDataType() != DT_INT)) {
+			Assign(Vector());
+			return false;
+		}
+		m_Ends = IntVector(ends);
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Appends the run-length vector to a buffer, e.g. in order to store
+	// it in a table file (see TableFile).
+	//
+	// Arguments:
+	// w - The writer appending to the buffer.
+	void SaveToBuffer(BinaryWriter &w) const {
+		w.Put((Int)m_Type);
+		w.Put(m_Ends);
+		w.Put(m_Values);
+	}
+
+	// Description:
+	// Loads a run-length vector from a buffer written by SaveToBuffer.
+	//
+	// Arguments:
+	// r - The reader of the buffer.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBuffer(BinaryReader &r) {
+		Int type;
+		Vector ends;
+		if (!r.Get(type) || !r.Get(ends) || !r.Get(m_Values) || (ends.Len() && ends.GetDataType() != DT_INT)) {
+			Assign(Vector());
+			return false;
+		}
+		m_Type = (DataType)type;
+		m_Ends = IntVector(ends);
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+private:
+	template<class T> static size_t CountRuns(const T *p, size_t Len) {
+		size_t n = Len ? 1 : 0;
+		for (size_t i=1; i<Len; i++) {
+			if (!ColumnData::IsIdentical(p[i], p[i-1])) n++;
+		}
+		return n;
+	}
+
+	template<class T> Bool AssignTyped(const Vector &v) {
+		const T *p = ColumnData::GetPtr<T>(v);
+		size_t Len = v.Len(), n = CountRuns(p, Len);
+		typename ColumnType<T>::VectorType values;
+		Int *pEnds = ColumnData::Alloc<Int>(m_Ends, n);
+		T *pValues = ColumnData::Alloc<T>(values, n);
+		if (!pEnds || !pValues) return false;
+		for (size_t i=0, r=0; i<Len; i++) {
+			if (i && ColumnData::IsIdentical(p[i], p[i-1])) continue;
+			if (r) pEnds[r-1] = (Int)i;
+			pValues[r++] = p[i];
+		}
+		pEnds[n-1] = (Int)Len;
+		m_Values = values;
+		return true;
+	}
+
+	template<class T> Vector ToVectorTyped() const {
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, Len());
+		if (!p) return v;
+		const Int *pEnds = m_Ends.GetPtr();
+		const T *pValues = ColumnData::GetPtr<T>(m_Values);
+		for (size_t r=0, i=0; r<m_Ends.Len(); i=pEnds[r++]) std::fill(p + i, p + pEnds[r], pValues[r]);
+		return v;
+	}
+
+	// checks the consistency of a loaded run-length vector
+	Bool IsValid() const {
+		size_t n = m_Ends.Len();
+		if (m_Values.Len() != n || (n ? m_Values.GetDataType() != m_Type : m_Type != DT_VOID)) return false;
+		for (size_t r=0; r<n; r++) {
+			if (m_Ends.GetPtr()[r] <= (r ? m_Ends.GetPtr()[r-1] : 0)) return false;
+		}
+		return true;
+	}
+
+	DataType  m_Type;   // data type of the elements
+	IntVector m_Ends;   // cumulative end of every run, ascending
+	Vector    m_Values; // value of every run
+};
+
+// {group:Enumeration Types}
+// Description: Vector Encodings.
+enum VectorEncoding {
+	VE_PLAIN  = 1, // Plain vector.
+	VE_SPARSE = 2, // Default value and exceptions (see SparseVector).
+	VE_DELTA  = 3, // Delta-of-delta encoding (see DeltaVector).
+	VE_RLE    = 4  // Run-length encoding (see RunLengthVector).
+};
+
+// {group:Data Classes}
+// Description: Encoded Vector Class.
+//
+// An encoded vector stores a vector using the most compact of the
+// available encodings (see VectorEncoding). The encoding is chosen
+// automatically by estimating the size of every applicable encoding,
+// or may be specified explicitly.
+//
+// Example:
+//   EncodedVector time(hTable->GetColumn("Time"));
+//   if (time.GetEncoding() == VE_DELTA) ...
+//   hTable->GetColumn("Time")->SetValues(time.ToVector());
+class EncodedVector {
+public:
+	// Description:
+	// Constructs an encoded vector.
+	//
+	// Arguments:
+	// v            - The (plain) vector to be represented.
+	// defaultValue - The default value for the sparse encoding (see
+	//                SparseVector).
+	// hVariable    - The column whose values are represented.
+	// fp           - The file pointer of a file storing an encoded
+	//                vector (see SaveToBinaryFile).
+	EncodedVector() : m_Encoding(VE_PLAIN) {}
+	EncodedVector(const Vector &v, const Value &defaultValue = Value()) : m_Encoding(VE_PLAIN) {
+		Assign(v, defaultValue);
+	}
+	EncodedVector(const IVariableHandle &hVariable) : m_Encoding(VE_PLAIN) {
+		Assign(hVariable);
+	}
+	EncodedVector(FILE *fp) : m_Encoding(VE_PLAIN) {
+		LoadFromBinaryFile(fp);
+	}
+
+	// Description:
+	// Encodes a vector or the values of a column using the most
+	// compact encoding (see ChooseEncoding) or a specified encoding.
+	// The default value of a column is the default value of its field
+	// definition.
+	//
+	// Arguments:
+	// v            - The (plain) vector to be represented.
+	// encoding     - The encoding.
+	// defaultValue - The default value for the sparse encoding.
+	// hVariable    - The column.
+	//
+	// Returns:
+	// true if the method succeeds, or false if the vector can not be
+	// represented using the encoding.
+	Bool Assign(const Vector &v, const Value &defaultValue = Value()) {
+		return Assign(v, ChooseEncoding(v, defaultValue), defaultValue);
+	}
+	Bool Assign(const Vector &v, VectorEncoding encoding, const Value &defaultValue = Value()) {
+		m_Plain = Vector();
+		m_Sparse.Assign(Vector());
+		m_Delta.Assign(Vector());
+		m_Rle.Assign(Vector());
+		m_Encoding = encoding;
+		switch (encoding) {
+			case VE_PLAIN:  m_Plain = v; return true;
+			case VE_SPARSE: if (m_Sparse.Assign(v, defaultValue)) return true; break;
+			case VE_DELTA:  if (m_Delta.Assign(v)) return true; break;
+			case VE_RLE:    if (m_Rle.Assign(v)) return true; break;
+			default:        break;
+		}
+		m_Encoding = VE_PLAIN;
+		return false;
+	}
+	Bool Assign(const IVariableHandle &hVariable) {
+		return Assign(hVariable->GetValues(), hVariable->GetFieldDef()->GetDefaultValue());
+	}
+
+	// Description:
+	// Returns the most compact encoding of a vector. An encoding is
+	// only chosen if it is smaller than the plain vector.
+	//
+	// Arguments:
+	// v            - The (plain) vector.
+	// defaultValue - The default value for the sparse encoding.
+	static VectorEncoding ChooseEncoding(const Vector &v, const Value &defaultValue = Value()) {
+		DataType dt = v.GetDataType();
+		size_t Len = v.Len();
+		size_t elemSize = dt == DT_STRING ? sizeof(String) : ColumnData::GetElementSize(dt);
+		if (!Len || !elemSize) return VE_PLAIN;
+		VectorEncoding encoding = VE_PLAIN;
+		size_t size = Len * elemSize;
+		size_t rleSize = RunLengthVector::CountRuns(v) * (elemSize + sizeof(Int));
+		if (rleSize < size) {
+			encoding = VE_RLE;
+			size = rleSize;
+		}
+		size_t sparseSize = (size_t)(SparseVector::GetDensity(v, defaultValue) * Len + 0.5) * (elemSize + sizeof(Int));
+		if (sparseSize < size) {
+			encoding = VE_SPARSE;
+			size = sparseSize;
+		}
+		if (DeltaVector::CanEncode(dt) && DeltaVector::GetEncodedSize(v) < size) encoding = VE_DELTA;
+		return encoding;
+	}
+
+	// Description:
+	// Converts the encoded vector to a plain vector.
+	Vector ToVector() const {
+		switch (m_Encoding) {
+			case VE_SPARSE: return m_Sparse.ToVector();
+			case VE_DELTA:  return m_Delta.ToVector();
+			case VE_RLE:    return m_Rle.ToVector();
+			default:        return m_Plain;
+		}
+	}
+
+	// Description:
+	// Assigns the (plain) values of the encoded vector to a column
+	// (see IVariable::SetValues).
+	Bool Store(IVariableHandle &hVariable) const {
+		return hVariable->SetValues(ToVector());
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the encoding.
+	VectorEncoding GetEncoding() const {
+		return m_Encoding;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the length of the (plain) vector.
+	size_t Len() const {
+		switch (m_Encoding) {
+			case VE_SPARSE: return m_Sparse.Len();
+			case VE_DELTA:  return m_Delta.Len();
+			case VE_RLE:    return m_Rle.Len();
+			default:        return m_Plain.Len();
+		}
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the data type of the elements.
+	DataType GetDataType() const {
+		switch (m_Encoding) {
+			case VE_SPARSE: return m_Sparse.GetDataType();
+			case VE_DELTA:  return m_Delta.GetDataType();
+			case VE_RLE:    return m_Rle.GetDataType();
+			default:        return m_Plain.GetDataType();
+		}
+	}
+
+	// Description:
+	// Returns an element.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	//
+	// Returns:
+	// The value of the element, or a void value if the index is out of
+	// range.
+	Value GetValue(size_t Index) const {
+		switch (m_Encoding) {
+			case VE_SPARSE: return m_Sparse.GetValue(Index);
+			case VE_DELTA:  return m_Delta.GetValue(Index);
+			case VE_RLE:    return m_Rle.GetValue(Index);
+			default:        return ColumnData::GetValue(m_Plain, Index);
+		}
+	}
+
+	// Description:
+	// Saves the encoded vector to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		Int encoding = m_Encoding;
+		if (fwrite(&encoding, sizeof(encoding), 1, fp) != 1) return false;
+		switch (m_Encoding) {
+			case VE_SPARSE: return m_Sparse.SaveToBinaryFile(fp);
+			case VE_DELTA:  return m_Delta.SaveToBinaryFile(fp);
+			case VE_RLE:    return m_Rle.SaveToBinaryFile(fp);
+			default:        return m_Plain.SaveToBinaryFile(fp);
+		}
+	}
+
+	// Description:
+	// Loads an encoded vector from a binary file written by
+	// SaveToBinaryFile.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		Int encoding;
+		Assign(Vector(), VE_PLAIN);
+		if (fread(&encoding, sizeof(encoding), 1, fp) != 1) return false;
+		m_Encoding = (VectorEncoding)encoding;
+		switch (m_Encoding) {
+			case VE_PLAIN:
+				m_Plain = Vector(fp);
+				if (!ferror(fp)) return true;
+				break;
+			case VE_SPARSE: if (m_Sparse.LoadFromBinaryFile(fp)) return true; break;
+			case VE_DELTA:  if (m_Delta.LoadFromBinaryFile(fp)) return true; break;
+			case VE_RLE:    if (m_Rle.LoadFromBinaryFile(fp)) return true; break;
+			default:        break;
+		}
+		Assign(Vector(), VE_PLAIN);
+		return false;
+	}
+
+	// Description:
+	// Appends the encoded vector to a buffer, e.g. in order to store it
+	// in a table file (see TableFile). Unlike SaveToBinaryFile, the
+	// encoding is not written, but has to be stored by the caller.
+	//
+	// Arguments:
+	// w - The writer appending to the buffer.
+	void SaveToBuffer(BinaryWriter &w) const {
+		switch (m_Encoding) {
+			case VE_SPARSE: m_Sparse.SaveToBuffer(w); break;
+			case VE_DELTA:  m_Delta.SaveToBuffer(w); break;
+			case VE_RLE:    m_Rle.SaveToBuffer(w); break;
+			default:        w.Put(m_Plain); break;
+		}
+	}
+
+	// Description:
+	// Loads an encoded vector from a buffer written by SaveToBuffer.
+	//
+	// Arguments:
+	// r        - The reader of the buffer.
+	// encoding - The encoding of the vector.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBuffer(BinaryReader &r, VectorEncoding encoding) {
+		Assign(Vector(), VE_PLAIN);
+		m_Encoding = encoding;
+		switch (m_Encoding) {
+			case VE_PLAIN:  if (r.Get(m_Plain)) return true; break;
+			case VE_SPARSE: if (m_Sparse.LoadFromBuffer(r)) return true; break;
+			case VE_DELTA:  if (m_Delta.LoadFromBuffer(r)) return true; break;
+			case VE_RLE:    if (m_Rle.LoadFromBuffer(r)) return true; break;
+			default:        break;
+		}
+		Assign(Vector(), VE_PLAIN);
+		return false;
+	}
+
+private:
+	VectorEncoding  m_Encoding;
+	Vector          m_Plain;  // VE_PLAIN
+	SparseVector    m_Sparse; // VE_SPARSE
+	DeltaVector     m_Delta;  // VE_DELTA
+	RunLengthVector m_Rle;    // VE_RLE
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_ENCODEDVECTOR_H_INCLUDED */
@@ -0,0 +1,196 @@
+#ifndef DCI_KEYTABLE_H_INCLUDED
+#define DCI_KEYTABLE_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ColumnData.h"
+
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// Description: Composite Key Hash Table.
+//
+// Maps composite keys, made up of the values of one or more key
+// columns of a record, to consecutive indexes (0, 1, 2, ...) in order
+// of insertion. The keys are stored contiguously and looked up in an
+// open-addressing hash table (linear probing). Every key column
+// value is represented as a 64-bit integer (see GetKey); string
+// columns are dictionary-encoded to integers first (see Encode).
+class KeyTable {
+public:
+	// Description:
+	// Raw data pointer and storage data type of a key column.
+	struct Column {
+		DataType    Type;
+		const void *Ptr;
+	};
+
+	// Description:
+	// Dictionary mapping strings to integer codes.
+	typedef std::unordered_map<String, Int, StringHash> Dictionary;
+
+	KeyTable(size_t noKeys) : m_NoKeys(noKeys), m_Mask(0), m_Count(0) {}
+
+	// Description:
+	// Resolves the raw data pointer of a byte, integer or double
+	// vector. Empty vectors of any type are treated as empty double
+	// columns.
+	//
+	// Returns:
+	// true if the vector can be used as a key column, or false
+	// otherwise.
+	static Bool GetColumn(const Vector &v, Column &column) {
+		column.Type = v.GetDataType();
+		switch (column.Type) {
+			case DT_BYTE:   column.Ptr = ColumnData::GetPtr<Byte>(v);   return true;
+			case DT_INT:    column.Ptr = ColumnData::GetPtr<Int>(v);    return true;
+			case DT_DOUBLE: column.Ptr = ColumnData::GetPtr<Double>(v); return true;
+			default:
+				column.Type = DT_DOUBLE;
+				column.Ptr  = 0;
+				return v.Len() == 0;
+		}
+	}
+
+	// Description:
+	// Replaces strings by their codes in a dictionary. If add is true,
+	// strings not yet contained in the dictionary are added (the code
+	// being the number of strings added before); otherwise, they are
+	// replaced by -1.
+	static IntVector Encode(const StringVector &sv, Dictionary &dict, Bool add) {
+		IntVector codes;
+		size_t n = sv.Len();
+		Int *p = ColumnData::Alloc<Int>(codes, n);
+		const String *pSrc = n ? sv.GetPtr() : 0;
+		for (size_t i=0; i<n; i++) {
+			Dictionary::iterator it = dict.find(pSrc[i]);
+			if (it == dict.end()) {
+				if (!add) {
+					p[i] = -1;
+					continue;
+				}
+				it = dict.insert(std::make_pair(pSrc[i], (Int)dict.size())).first;
+			}
+			p[i] = it->second;
+		}
+		return codes;
+	}
+
+	// Description:
+	// Returns the value of a key column as a 64-bit integer. Doubles
+	// are represented by their bit pattern; -0.0 and 0.0 as well as
+	// all NaNs yield the same key.
+	static long long GetKey(const Column &column, size_t i) {
+		switch (column.Type) {
+			case DT_BYTE: return ((const Byte *)column.Ptr)[i];
+			case DT_INT:  return ((const Int *)column.Ptr)[i];
+			default: {
+				Double d = ((const Double *)column.Ptr)[i];
+				if (d == 0.0) d = 0.0;
+				if (d != d) return -1LL;
+				long long h;
+				memcpy(&h, &d, sizeof(h));
+				return h;
+			}
+		}
+	}
+
+	// Description:
+	// Tests if the value of a key column is missing.
+	static Bool IsMissing(const Column &column, size_t i) {
+		switch (column.Type) {
+			case DT_BYTE: return ColumnData::IsMissing(((const Byte *)column.Ptr)[i]);
+			case DT_INT:  return ColumnData::IsMissing(((const Int *)column.Ptr)[i]);
+			default:      return ColumnData::IsMissing(((const Double *)column.Ptr)[i]);
+		}
+	}
+
+	// Description:
+	// Fills the composite key of a record.
+	static void GetKey(const std::vector<Column> &columns, size_t i, long long *key) {
+		for (size_t k=0; k<columns.size(); k++) key[k] = GetKey(columns[k], i);
+	}
+
+	// Description:
+	// Returns the number of keys in the table.
+	size_t GetCount() const {
+		return m_NoKeys ? m_Keys.size() / m_NoKeys : m_Count;
+	}
+
+	// Description:
+	// Returns the key with the specified index.
+	const long long *GetStoredKey(size_t idx) const {
+		return m_NoKeys ? &m_Keys[idx * m_NoKeys] : 0;
+	}
+
+	// Description:
+	// Returns the index of a key; the key is added if necessary. If
+	// the key was added, the index equals the previous count.
+	size_t FindOrAdd(const long long *key) {
+		if (2 * (GetCount() + 1) > m_Slots.size()) Grow();
+		for (size_t i = Hash(key) & m_Mask; ; i = (i + 1) & m_Mask) {
+			UInt slot = m_Slots[i];
+			if (!slot) {
+				m_Slots[i] = (UInt)GetCount() + 1;
+				if (m_NoKeys) m_Keys.insert(m_Keys.end(), key, key + m_NoKeys);
+				else m_Count++;
+				return GetCount() - 1;
+			}
+			if (IsEqual(slot - 1, key)) return slot - 1;
+		}
+	}
+
+	// Description:
+	// Returns the index of a key, or GetCount() if the key is not
+	// contained in the table. The method does not modify the table,
+	// so it may be called on multiple threads concurrently.
+	size_t Find(const long long *key) const {
+		if (m_Slots.empty()) return GetCount();
+		for (size_t i = Hash(key) & m_Mask; ; i = (i + 1) & m_Mask) {
+			UInt slot = m_Slots[i];
+			if (!slot) return GetCount();
+			if (IsEqual(slot - 1, key)) return slot - 1;
+		}
+	}
+
+private:
+	size_t Hash(const long long *key) const {
+		unsigned long long h = 0x9e3779b97f4a7c15ULL;
+		for (size_t k=0; k<m_NoKeys; k++) {
+			h ^= (unsigned long long)key[k];
+			// mix the bits (splitmix64 finalizer)
+			h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+			h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+			h ^= h >> 31;
+		}
+		return (size_t)h;
+	}
+
+	Bool IsEqual(size_t idx, const long long *key) const {
+		return !m_NoKeys || !memcmp(&m_Keys[idx * m_NoKeys], key, m_NoKeys * sizeof(long long));
+	}
+
+	void Grow() {
+		size_t size = m_Slots.empty() ? 1024 : 2 * m_Slots.size();
+		m_Slots.assign(size, 0);
+		m_Mask = size - 1;
+		for (size_t idx=0; idx<GetCount(); idx++) {
+			size_t i = Hash(GetStoredKey(idx)) & m_Mask;
+			while (m_Slots[i]) i = (i + 1) & m_Mask;
+			m_Slots[i] = (UInt)idx + 1;
+		}
+	}
+
+	size_t                 m_NoKeys;
+	size_t                 m_Mask;
+	size_t                 m_Count;     // number of (empty) keys if m_NoKeys is 0
+	std::vector<UInt>      m_Slots;     // hash table: key index + 1, or 0 if empty
+	std::vector<long long> m_Keys;      // m_NoKeys values per key
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_KEYTABLE_H_INCLUDED */
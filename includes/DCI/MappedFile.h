@@ -0,0 +1,147 @@
+#ifndef DCI_MAPPEDFILE_H_INCLUDED
+#define DCI_MAPPEDFILE_H_INCLUDED
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "DCI/DCI.h"
+
+namespace DCI {
+
+// {internal}
+// Description: Mapped File Class.
+//
+// Maps a whole file read-only into the address space of the process,
+// so that its contents can be accessed through a pointer without
+// reading them into memory first. Pages are loaded by the operating
+// system on first access and may be dropped again under memory
+// pressure, as they are backed by the file.
+//
+// Please note, that a 32-bit process may not be able to map very
+// large files.
+class MappedFile {
+public:
+	// Description:
+	// Constructs a mapped file.
+	//
+	// Arguments:
+	// FileName - The name of the file to be mapped.
+#ifdef WIN32
+	MappedFile() : m_File(INVALID_HANDLE_VALUE), m_Mapping(0), m_pData(0), m_Size(0) {}
+	MappedFile(const String &FileName) : m_File(INVALID_HANDLE_VALUE), m_Mapping(0), m_pData(0), m_Size(0) {
+		Open(FileName);
+	}
+#else
+	MappedFile() : m_File(-1), m_pData(0), m_Size(0) {}
+	MappedFile(const String &FileName) : m_File(-1), m_pData(0), m_Size(0) {
+		Open(FileName);
+	}
+#endif
+	~MappedFile() {
+		Close();
+	}
+
+	// Description:
+	// Maps a file. A file mapped before is unmapped first.
+	//
+	// Arguments:
+	// FileName - The name of the file to be mapped.
+	//
+	// Returns:
+	// true if the file was mapped, or false if it could not be opened
+	// or mapped, or if it is empty.
+	Bool Open(const String &FileName) {
+		Close();
+#ifdef WIN32
+		m_File = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (m_File == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_File, &size) || !size.QuadPart || (unsigned long long)size.QuadPart > (size_t)-1) {
+			Close();
+			return false;
+		}
+		m_Mapping = CreateFileMappingA(m_File, 0, PAGE_READONLY, 0, 0, 0);
+		if (m_Mapping) m_pData = (const char *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		m_Size = (size_t)size.QuadPart;
+#else
+		m_File = open(FileName, O_RDONLY);
+		if (m_File == -1) return false;
+		struct stat st;
+		if (fstat(m_File, &st) || !st.st_size || (unsigned long long)st.st_size > (size_t)-1) {
+			Close();
+			return false;
+		}
+		void *p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, m_File, 0);
+		if (p != MAP_FAILED) m_pData = (const char *)p;
+		m_Size = (size_t)st.st_size;
+#endif
+		if (!m_pData) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Unmaps the file. Pointers into the mapped file become invalid.
+	void Close() {
+#ifdef WIN32
+		if (m_pData) UnmapViewOfFile(m_pData);
+		if (m_Mapping) CloseHandle(m_Mapping);
+		if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+		m_Mapping = 0;
+#else
+		if (m_pData) munmap((void *)m_pData, m_Size);
+		if (m_File != -1) close(m_File);
+		m_File = -1;
+#endif
+		m_pData = 0;
+		m_Size = 0;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Tests if a file is mapped.
+	Bool IsOpen() const {
+		return m_pData != 0;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns a pointer to the first byte of the mapped file, or NULL
+	// if no file is mapped.
+	const char *GetPtr() const {
+		return m_pData;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the size of the mapped file in bytes.
+	size_t GetSize() const {
+		return m_Size;
+	}
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator = (const MappedFile &);
+
+#ifdef WIN32
+	HANDLE      m_File;
+	HANDLE      m_Mapping;
+#else
+	int         m_File;
+#endif
+	const char *m_pData; // mapped view
+	size_t      m_Size;  // size of the file
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_MAPPEDFILE_H_INCLUDED */
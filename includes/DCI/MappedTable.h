@@ -0,0 +1,796 @@
+#ifndef DCI_MAPPEDTABLE_H_INCLUDED
+#define DCI_MAPPEDTABLE_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/BinaryBuffer.h"
+#include "DCI/BlockCompression.h"
+#include "DCI/ColumnData.h"
+#include "DCI/EncodedVector.h"
+#include "DCI/Manager.h"
+#include "DCI/MappedFile.h"
+#include "DCI/Parallel.h"
+#include "DCI/TableOperations.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// Description: Table File Constants.
+enum {
+	TableFileVersion   = 2, // version of the columnar table file format
+	TableFileAlignment = 64 // alignment of the column payloads in bytes
+};
+
+// {internal}
+// Description: Table File Header.
+//
+// A columnar table file (see TableFile::Save) consists of the header,
+// the column directory (one TableFileColumn per column), the schema
+// block (see TableFileSchema) and the column payloads, each of which
+// starts at a multiple of TableFileAlignment bytes. All numbers are
+// stored in the byte order of the machine writing the file.
+struct TableFileHeader {
+	char               Magic[8];     // "DCITABLE"
+	UInt               Version;      // TableFileVersion
+	UInt               NoColumns;    // number of columns
+	unsigned long long NoRecords;    // number of records
+	unsigned long long SchemaOffset; // offset of the schema block
+	unsigned long long SchemaSize;   // size of the schema block in bytes
+};
+
+// {internal}
+// Description: Table File Column Directory Entry.
+//
+// The payload of a plain byte, integer or double column holds its
+// elements. The payload of a plain string column holds NoRecords + 1
+// offsets (unsigned long long) into the character data that follows
+// them; every string is stored zero-terminated. The payload of a
+// sparse, delta or run-length encoded column holds the encoded vector
+// (see EncodedVector::SaveToBuffer). Compressed payloads (see
+// BlockCompression) hold one of these payloads in compressed form;
+// the filters of plain byte, integer and double columns operate on
+// their elements, those of other columns on single bytes.
+struct TableFileColumn {
+	Int                DataType; // storage data type of the elements
+	Int                Encoding; // encoding of the payload (see VectorEncoding)
+	Int                Codec;    // compression of the payload (see CompressionCodec)
+	Int                Reserved; // 0
+	unsigned long long Offset;   // offset of the payload
+	unsigned long long Size;     // size of the payload in bytes
+
+	// returns the width of the elements the compression filters operate on
+	size_t GetFilterWidth() const {
+		return (Encoding == VE_PLAIN && DataType != DT_STRING) ? ColumnData::GetElementSize((DCI::DataType)DataType) : 1;
+	}
+};
+
+// {internal}
+// Description: Table File Schema.
+//
+// The schema of a table as stored in the schema block of a table file:
+// the name, description and attributes of the table, and the key,
+// data type, minimum, maximum, default and allowed values, name,
+// description and attributes of every field definition.
+class TableFileSchema {
+public:
+	struct Attribute {
+		String Key;
+		String Name;
+		String StringValue;
+	};
+	struct Object {
+		String                 Name;
+		String                 Description;
+		std::vector<Attribute> Attributes;
+	};
+	struct Field : public Object {
+		String   Key;
+		DataType Type;
+		Value    MinValue;
+		Value    MaxValue;
+		Value    DefaultValue;
+		Vector   AllowedValues;
+	};
+
+	Object             Table;
+	std::vector<Field> Fields;
+
+	// Description:
+	// Takes the schema from a table.
+	void Assign(ITableHandle &hTable) {
+		AssignObject(Table, hTable);
+		IFieldDefsHandle hDefs = hTable->GetFieldDefs();
+		Fields.resize(hDefs->GetCount());
+		for (UInt c=1; c<=Fields.size(); c++) {
+			IFieldDefHandle hDef = hDefs->Item(c);
+			Field &field = Fields[c-1];
+			AssignObject(field, hDef);
+			field.Key           = hDefs->KeyOf(c);
+			field.Type          = hDef->GetDataType();
+			field.MinValue      = hDef->GetMinValue();
+			field.MaxValue      = hDef->GetMaxValue();
+			field.DefaultValue  = hDef->GetDefaultValue();
+			field.AllowedValues = hDef->GetAllowedValues();
+		}
+	}
+
+	// Description:
+	// Creates a (column-based) table with the schema, restricted to
+	// the specified fields.
+	//
+	// Arguments:
+	// fieldIdxs - The (0-based) indexes of the fields, in the order of
+	//             the new table's columns.
+	//
+	// Returns:
+	// The new table, or an empty handle in case of an error.
+	ITableHandle CreateTable(const std::vector<UInt> &fieldIdxs) const {
+		ITableHandle hTable = Manager::CreateTable();
+		if (!hTable || !ApplyObject(Table, hTable) || !hTable->SetRecordBased(false)) return ITableHandle();
+		IFieldDefsHandle hDefs = hTable->GetFieldDefs();
+		for (size_t i=0; i<fieldIdxs.size(); i++) {
+			const Field &field = Fields[fieldIdxs[i]];
+			IFieldDefHandle hNoDef;
+			IFieldDefHandle hDef = hDefs->AddNew(field.Key, hNoDef);
+			if (!hDef || !hDef->SetDataType(field.Type) || !ApplyObject(field, hDef)) return ITableHandle();
+			if ((field.MinValue.GetDataType() != DT_VOID && !hDef->SetMinValue(field.MinValue)) ||
+				(field.MaxValue.GetDataType() != DT_VOID && !hDef->SetMaxValue(field.MaxValue)) ||
+				(field.DefaultValue.GetDataType() != DT_VOID && !hDef->SetDefaultValue(field.DefaultValue)) ||
+				(field.AllowedValues.Len() && !hDef->SetAllowedValues(field.AllowedValues))) return ITableHandle();
+		}
+		return hTable;
+	}
+
+	// Description:
+	// Appends the serialized schema to a buffer.
+	void Write(std::vector<char> &buffer) const {
+		BinaryWriter w(buffer);
+		WriteObject(w, Table);
+		w.Put((UInt)Fields.size());
+		for (size_t c=0; c<Fields.size(); c++) {
+			const Field &field = Fields[c];
+			WriteObject(w, field);
+			w.Put(field.Key);
+			w.Put((Int)field.Type);
+			w.Put(field.MinValue);
+			w.Put(field.MaxValue);
+			w.Put(field.DefaultValue);
+			w.Put(field.AllowedValues);
+		}
+	}
+
+	// Description:
+	// Reads a schema serialized by Write.
+	//
+	// Returns:
+	// true if the schema was read, or false if it is corrupt.
+	Bool Read(const char *p, size_t Len) {
+		BinaryReader r(p, Len);
+		UInt noFields;
+		Fields.clear();
+		if (!ReadObject(r, Table) || !r.Get(noFields) || noFields > Len) return false;
+		Fields.resize(noFields);
+		for (size_t c=0; c<noFields; c++) {
+			Field &field = Fields[c];
+			Int type;
+			if (!ReadObject(r, field) || !r.Get(field.Key) || !r.Get(type) || !r.Get(field.MinValue) ||
+				!r.Get(field.MaxValue) || !r.Get(field.DefaultValue) || !r.Get(field.AllowedValues)) return false;
+			field.Type = (DataType)type;
+		}
+		return true;
+	}
+
+private:
+	template<class H> static void AssignObject(Object &obj, const H &hObject) {
+		obj.Name        = hObject->GetName();
+		obj.Description = hObject->GetDescription();
+		IAttributesHandle hAttrs = hObject->GetAttributes();
+		obj.Attributes.resize(hAttrs ? hAttrs->GetCount() : 0);
+		for (UInt a=1; a<=obj.Attributes.size(); a++) {
+			IAttributeHandle hAttr = hAttrs->Item(a);
+			obj.Attributes[a-1].Key         = hAttrs->KeyOf(a);
+			obj.Attributes[a-1].Name        = hAttr->GetName();
+			obj.Attributes[a-1].StringValue = hAttr->GetStringValue();
+		}
+	}
+
+	template<class H> static Bool ApplyObject(const Object &obj, H &hObject) {
+		hObject->SetName(obj.Name);
+		hObject->SetDescription(obj.Description);
+		if (obj.Attributes.empty()) return true;
+		IAttributesHandle hAttrs = hObject->GetAttributes();
+		if (!hAttrs) return false;
+		for (size_t a=0; a<obj.Attributes.size(); a++) {
+			IAttributeHandle hNoAttr;
+			IAttributeHandle hAttr = hAttrs->AddNew(obj.Attributes[a].Key, hNoAttr);
+			if (!hAttr) return false;
+			hAttr->SetName(obj.Attributes[a].Name);
+			hAttr->SetStringValue(obj.Attributes[a].StringValue);
+		}
+		return true;
+	}
+
+	static void WriteObject(BinaryWriter &w, const Object &obj) {
+		w.Put(obj.Name);
+		w.Put(obj.Description);
+		w.Put((UInt)obj.Attributes.size());
+		for (size_t a=0; a<obj.Attributes.size(); a++) {
+			w.Put(obj.Attributes[a].Key);
+			w.Put(obj.Attributes[a].Name);
+			w.Put(obj.Attributes[a].StringValue);
+		}
+	}
+
+	static Bool ReadObject(BinaryReader &r, Object &obj) {
+		UInt noAttrs;
+		if (!r.Get(obj.Name) || !r.Get(obj.Description) || !r.Get(noAttrs) || noAttrs > r.GetRemaining()) return false;
+		obj.Attributes.resize(noAttrs);
+		for (size_t a=0; a<noAttrs; a++) {
+			if (!r.Get(obj.Attributes[a].Key) || !r.Get(obj.Attributes[a].Name) || !r.Get(obj.Attributes[a].StringValue)) return false;
+		}
+		return true;
+	}
+};
+
+// {group:Data Classes}
+// Description: Mapped Table Class.
+//
+// A mapped table gives read-only access to a table stored in a
+// columnar table file (see TableFile::Save) by mapping the file into
+// memory (see MappedFile) instead of reading it. Opening the file only
+// reads the header, the column directory and the schema; the values of
+// fixed-width columns are accessed in place (see GetColumnPtr), and
+// pages of the file are loaded on first access, so that the memory
+// used is proportional to the data actually accessed.
+//
+// Compressed and encoded columns (see TableFile::Save) cannot be
+// accessed in place. Compressed columns are decompressed into memory on
+// first access; encoded columns are decoded on first access, and single
+// values are looked up in the encoded vector (see
+// EncodedVector::GetValue).
+//
+// Mapped tables are copy-on-write: the first modification (see
+// SetValue) or a call to GetTable copies the schema and all values
+// into an ordinary table, which then replaces the mapping; all further
+// accesses go to that table. This unmaps the file, so that pointers
+// returned by GetColumnPtr before become invalid.
+//
+// Example:
+//   MappedTable results("Results.dct");
+//   const Double *pTime = results.GetColumnPtr<Double>(results.IndexOf("Time"));
+//   for (UInt r=0; r<results.GetRecordCount(); r++) ... pTime[r] ...
+class MappedTable {
+public:
+	// Description:
+	// Constructs a mapped table.
+	//
+	// Arguments:
+	// FileName - The name of the table file to be mapped.
+	MappedTable() : m_NoRecords(0) {}
+	MappedTable(const String &FileName) : m_NoRecords(0) {
+		Open(FileName);
+	}
+
+	// Description:
+	// Maps a table file. A table mapped or materialized before is
+	// closed first.
+	//
+	// Arguments:
+	// FileName - The name of the table file.
+	//
+	// Returns:
+	// true if the file was mapped, or false if it could not be mapped
+	// or is not a valid table file.
+	Bool Open(const String &FileName) {
+		Close();
+		if (!m_File.Open(FileName)) return false;
+		const char *p = m_File.GetPtr();
+		size_t size = m_File.GetSize();
+		TableFileHeader header;
+		if (size < sizeof(header)) return Fail();
+		memcpy(&header, p, sizeof(header));
+		if (memcmp(header.Magic, "DCITABLE", sizeof(header.Magic)) || header.Version != TableFileVersion ||
+			header.NoRecords > (UInt)-1 || header.NoColumns > (size - sizeof(header)) / sizeof(TableFileColumn) ||
+			!IsInFile(header.SchemaOffset, header.SchemaSize)) return Fail();
+		m_NoRecords = (UInt)header.NoRecords;
+		m_Columns.resize(header.NoColumns);
+		m_States.resize(header.NoColumns);
+		if (header.NoColumns) memcpy(&m_Columns[0], p + sizeof(header), header.NoColumns * sizeof(TableFileColumn));
+		if (!m_Schema.Read(p + header.SchemaOffset, (size_t)header.SchemaSize) || m_Schema.Fields.size() != m_Columns.size()) return Fail();
+		for (UInt c=1; c<=m_Columns.size(); c++) {
+			if (!IsValidColumn(c)) return Fail();
+		}
+		return true;
+	}
+
+	// Description:
+	// Closes the table: unmaps the file and releases the materialized
+	// table.
+	void Close() {
+		m_File.Close();
+		m_Table = ITableHandle();
+		m_Columns.clear();
+		m_States.clear();
+		m_Schema = TableFileSchema();
+		m_NoRecords = 0;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Tests if a table file is mapped or the table is materialized.
+	Bool IsOpen() const {
+		return m_File.IsOpen() || m_Table;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Tests if the table has been materialized (see GetTable).
+	Bool IsMaterialized() const {
+		return m_Table;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of records.
+	UInt GetRecordCount() const {
+		return m_Table ? (m_Table->GetColumns()->GetCount() ? m_Table->GetColumns()->Item(1)->GetLength() : 0) : m_NoRecords;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of columns.
+	UInt GetColumnCount() const {
+		return m_Table ? m_Table->GetFieldDefs()->GetCount() : (UInt)m_Schema.Fields.size();
+	}
+
+	// Description:
+	// Returns the key of a column.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	String GetColumnKey(UInt colIdx) const {
+		if (m_Table) return m_Table->GetFieldDefs()->KeyOf(colIdx);
+		return (colIdx >= 1 && colIdx <= GetColumnCount()) ? m_Schema.Fields[colIdx-1].Key : String();
+	}
+
+	// Description:
+	// Returns the index of a column.
+	//
+	// Arguments:
+	// colKey - Key associated with the column.
+	//
+	// Returns:
+	// The index (1-based), or 0 if there is no such column.
+	UInt IndexOf(const String &colKey) const {
+		if (m_Table) return m_Table->GetFieldDefs()->IndexOf(colKey);
+		for (UInt c=1; c<=GetColumnCount(); c++) {
+			if (m_Schema.Fields[c-1].Key == colKey) return c;
+		}
+		return 0;
+	}
+
+	// Description:
+	// Returns the data type of a column (see IFieldDef::GetDataType).
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	DataType GetDataType(UInt colIdx) const {
+		if (m_Table) return (colIdx >= 1 && colIdx <= GetColumnCount()) ? m_Table->GetFieldDefs()->Item(colIdx)->GetDataType() : DT_VOID;
+		return (colIdx >= 1 && colIdx <= GetColumnCount()) ? m_Schema.Fields[colIdx-1].Type : DT_VOID;
+	}
+
+	// Description:
+	// Returns a read-only pointer to the values of a fixed-width column
+	// stored in the mapped file (or decompressed from it), or, if the
+	// table is materialized, in the table's column (see
+	// ColumnData::GetPtr). T must match the storage data type of the
+	// column.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	//
+	// Please note, that the pointer becomes invalid when the table is
+	// materialized (see SetValue and GetTable), as this unmaps the file,
+	// and, afterwards, when the column's values are changed.
+	//
+	// Returns:
+	// The pointer to the first value, or NULL if the column is empty,
+	// its storage data type does not match T, it is encoded or its
+	// compressed values are corrupt.
+	template<class T> const T *GetColumnPtr(UInt colIdx) const {
+		if (colIdx < 1 || colIdx > GetColumnCount()) return 0;
+		if (m_Table) return ColumnData::GetPtr<T>(m_Table->GetColumn(colIdx)->GetValues());
+		const TableFileColumn &column = m_Columns[colIdx-1];
+		if (!m_NoRecords || column.DataType != ColumnType<T>::GetDataType() || column.Encoding != VE_PLAIN) return 0;
+		return (const T *)GetPayload(colIdx);
+	}
+
+	// Description:
+	// Returns the value of a field (cell).
+	//
+	// Arguments:
+	// recIdx - Index of the record. The index of the first record is 1.
+	// colIdx - Index of the column. The index of the first column is 1.
+	// colKey - Key associated with the column.
+	//
+	// Returns:
+	// The value, or a void value if the indexes are out of range.
+	Value GetValue(UInt recIdx, UInt colIdx) const {
+		if (m_Table) return m_Table->GetValue(recIdx, colIdx);
+		if (recIdx < 1 || recIdx > m_NoRecords || colIdx < 1 || colIdx > GetColumnCount()) return Value();
+		size_t i = recIdx - 1;
+		if (m_Columns[colIdx-1].Encoding != VE_PLAIN) {
+			const EncodedVector *pEncoded = GetEncoded(colIdx);
+			return pEncoded ? pEncoded->GetValue(i) : Value();
+		}
+		switch (m_Columns[colIdx-1].DataType) {
+			case DT_BYTE:   return GetFixed<Byte>(colIdx, i);
+			case DT_INT:    return GetFixed<Int>(colIdx, i);
+			case DT_DOUBLE: return GetFixed<Double>(colIdx, i);
+			case DT_STRING: return Value(GetString(colIdx, i));
+			default:        return Value();
+		}
+	}
+	Value GetValue(UInt recIdx, const String &colKey) const {
+		return GetValue(recIdx, IndexOf(colKey));
+	}
+
+	// Description:
+	// Returns the values of a column. Values of a mapped file are
+	// copied into the vector.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	//
+	// Returns:
+	// The values, or an empty vector if the index is out of range.
+	Vector GetValues(UInt colIdx) const {
+		if (colIdx < 1 || colIdx > GetColumnCount()) return Vector();
+		if (m_Table) return m_Table->GetColumn(colIdx)->GetValues();
+		if (m_Columns[colIdx-1].Encoding != VE_PLAIN) {
+			const EncodedVector *pEncoded = GetEncoded(colIdx);
+			return pEncoded ? pEncoded->ToVector() : Vector();
+		}
+		switch (m_Columns[colIdx-1].DataType) {
+			case DT_BYTE:   return CopyFixed<Byte>(colIdx);
+			case DT_INT:    return CopyFixed<Int>(colIdx);
+			case DT_DOUBLE: return CopyFixed<Double>(colIdx);
+			case DT_STRING: return CopyStrings(colIdx);
+			default:        return Vector();
+		}
+	}
+
+	// Description:
+	// Sets the value of a field (cell). The table is materialized
+	// first (see GetTable).
+	//
+	// Arguments:
+	// recIdx   - Index of the record. The index of the first record is 1.
+	// colIdx   - Index of the column. The index of the first column is 1.
+	// colKey   - Key associated with the column.
+	// newValue - The new value.
+	//
+	// Returns:
+	// true if the method succeeds, or false otherwise.
+	Bool SetValue(UInt recIdx, UInt colIdx, const Value &newValue) {
+		ITableHandle hTable = GetTable();
+		return hTable && hTable->SetValue(recIdx, colIdx, newValue);
+	}
+	Bool SetValue(UInt recIdx, const String &colKey, const Value &newValue) {
+		return SetValue(recIdx, IndexOf(colKey), newValue);
+	}
+
+	// Description:
+	// Returns the table as an ordinary (record-based) table. On the
+	// first call, the schema and all values are copied from the mapped
+	// file into a new table, and the file is unmapped; later calls
+	// return the same table.
+	//
+	// Returns:
+	// The table, or an empty handle in case of an error.
+	ITableHandle GetTable() {
+		if (m_Table || !m_File.IsOpen()) return m_Table;
+		std::vector<UInt> colIdxs(GetColumnCount());
+		for (UInt c=0; c<colIdxs.size(); c++) colIdxs[c] = c + 1;
+		ITableHandle hTable = CopyColumns(colIdxs);
+		if (!hTable) return ITableHandle();
+		m_Table = hTable;
+		m_File.Close();
+		m_States.assign(m_States.size(), ColumnState());
+		return m_Table;
+	}
+
+	// Description:
+	// Copies some columns into a new (record-based) table, e.g. in order
+	// to load only the columns needed from a large table file. Only the
+	// pages of the copied columns are read; the mapped table is not
+	// materialized.
+	//
+	// The blocks of all compressed columns are decompressed in one
+	// parallel loop (using at most Parallel::GetThreadCount threads),
+	// and the values of fixed-width columns are copied (or decompressed)
+	// in parallel into vectors allocated beforehand. As strings and
+	// values are reference counted, string columns and encoded columns
+	// are converted into vectors by the calling thread; loading string
+	// columns therefore gains from parallelism only if they are
+	// compressed.
+	//
+	// Arguments:
+	// colIdxs - The indexes of the columns, in the order of the new
+	//           table's columns. The index of the first column is 1.
+	//
+	// Returns:
+	// The new table, or an empty handle in case of an error.
+	ITableHandle CopyColumns(const std::vector<UInt> &colIdxs) const {
+		std::vector<UInt> fieldIdxs(colIdxs.size());
+		for (size_t i=0; i<colIdxs.size(); i++) {
+			if (colIdxs[i] < 1 || colIdxs[i] > GetColumnCount()) return ITableHandle();
+			fieldIdxs[i] = colIdxs[i] - 1;
+		}
+		if (m_Table) {
+			// the schema of the materialized table may have been changed
+			ITableHandle hSrc = m_Table;
+			StringVector colKeys;
+			if (!colKeys.ReDim(colIdxs.size())) return ITableHandle();
+			for (size_t i=0; i<colIdxs.size(); i++) colKeys[i] = GetColumnKey(colIdxs[i]);
+			return TableOperations::Project(hSrc, colKeys);
+		}
+		ITableHandle hTable = m_Schema.CreateTable(fieldIdxs);
+		if (!hTable) return ITableHandle();
+		std::vector<Vector> values;
+		if (!LoadColumns(colIdxs, values)) return ITableHandle();
+		IVariablesHandle hCols = hTable->GetColumns();
+		for (UInt c=1; c<=colIdxs.size(); c++) {
+			if (!hCols->Item(c)->SetValues(values[c-1])) return ITableHandle();
+		}
+		if (!hTable->SetRecordBased(true)) return ITableHandle();
+		return hTable;
+	}
+
+private:
+	// {internal}
+	// Description:
+	// Compressed or encoded column, loaded from the mapped file on first
+	// access.
+	struct ColumnState {
+		Bool              IsDecompressed; // the payload has been decompressed
+		Bool              IsDecoded;      // the encoded vector has been decoded
+		Bool              IsValid;        // the payload (or encoded vector) is not corrupt
+		std::vector<char> Payload;        // decompressed payload
+		EncodedVector     Encoded;        // decoded encoded vector
+
+		ColumnState() : IsDecompressed(false), IsDecoded(false), IsValid(false), Encoded(Vector()) {}
+	};
+
+	MappedTable(const MappedTable &);
+	MappedTable &operator = (const MappedTable &);
+
+	Bool Fail() {
+		Close();
+		return false;
+	}
+
+	Bool IsInFile(unsigned long long offset, unsigned long long size) const {
+		return offset <= m_File.GetSize() && size <= m_File.GetSize() - offset;
+	}
+
+	// checks the directory entry of a column, and the payload unless it is compressed or encoded
+	Bool IsValidColumn(UInt colIdx) const {
+		const TableFileColumn &column = m_Columns[colIdx-1];
+		if (column.Offset % TableFileAlignment || !IsInFile(column.Offset, column.Size)) return false;
+		if (column.DataType != ColumnData::GetStorageType(m_Schema.Fields[colIdx-1].Type)) return false;
+		if (column.Codec < CC_NONE || column.Codec > CC_XOR_SHUFFLE_LZ) return false;
+		if (column.Encoding != VE_PLAIN) {
+			return column.Encoding == VE_SPARSE || column.Encoding == VE_DELTA || column.Encoding == VE_RLE;
+		}
+		return column.Codec != CC_NONE || IsValidPayload(colIdx, m_File.GetPtr() + column.Offset, column.Size);
+	}
+
+	// checks the (decompressed) payload of a plain column
+	Bool IsValidPayload(UInt colIdx, const char *p, unsigned long long size) const {
+		const TableFileColumn &column = m_Columns[colIdx-1];
+		if (column.DataType == DT_STRING) {
+			return size >= (m_NoRecords + 1ULL) * sizeof(unsigned long long) &&
+				((const unsigned long long *)p)[m_NoRecords] <= size - (m_NoRecords + 1ULL) * sizeof(unsigned long long);
+		}
+		size_t elemSize = ColumnData::GetElementSize((DataType)column.DataType);
+		return elemSize && size == (unsigned long long)m_NoRecords * elemSize;
+	}
+
+	// block index of a task of LoadColumns copying a column
+	static const size_t NoBlock = (size_t)-1;
+
+	// returns the payload of a column, decompressed on first access, or NULL if it is corrupt;
+	// a payload that is not compressed or has been decompressed before is returned without
+	// allocating, so that worker threads can copy it (see LoadColumns)
+	const char *GetPayload(UInt colIdx, size_t &size) const {
+		const TableFileColumn &column = m_Columns[colIdx-1];
+		if (column.Codec == CC_NONE) {
+			size = (size_t)column.Size;
+			return m_File.GetPtr() + column.Offset;
+		}
+		ColumnState &state = m_States[colIdx-1];
+		if (!state.IsDecompressed) {
+			state.IsDecompressed = true;
+			const char *p = m_File.GetPtr() + column.Offset;
+			unsigned long long rawSize;
+			if (BlockCompression::GetRawSize(p, (size_t)column.Size, rawSize) && rawSize <= (size_t)-1) {
+				state.Payload.resize((size_t)rawSize);
+				state.IsValid = BlockCompression::Decompress(p, (size_t)column.Size, column.GetFilterWidth(), (CompressionCodec)column.Codec, state.Payload.data(), (size_t)rawSize) &&
+					(column.Encoding != VE_PLAIN || IsValidPayload(colIdx, state.Payload.data(), rawSize));
+			}
+			if (!state.IsValid) std::vector<char>().swap(state.Payload);
+		}
+		size = state.Payload.size();
+		return state.IsValid ? state.Payload.data() : 0;
+	}
+	const char *GetPayload(UInt colIdx) const {
+		size_t size;
+		return GetPayload(colIdx, size);
+	}
+
+	// returns the decoded encoded vector of a column, or NULL if the payload is corrupt
+	const EncodedVector *GetEncoded(UInt colIdx) const {
+		const TableFileColumn &column = m_Columns[colIdx-1];
+		ColumnState &state = m_States[colIdx-1];
+		if (!state.IsDecoded) {
+			state.IsDecoded = true;
+			size_t size;
+			const char *p = GetPayload(colIdx, size);
+			BinaryReader r(p, p ? size : 0);
+			state.IsValid = p && state.Encoded.LoadFromBuffer(r, (VectorEncoding)column.Encoding) && state.Encoded.Len() == m_NoRecords &&
+				(!m_NoRecords || state.Encoded.GetDataType() == column.DataType);
+			// the encoded vector holds copies of the data
+			std::vector<char>().swap(state.Payload);
+		}
+		return state.IsValid ? &state.Encoded : 0;
+	}
+
+	// loads the values of some columns of the mapped file in parallel (see CopyColumns)
+	Bool LoadColumns(const std::vector<UInt> &colIdxs, std::vector<Vector> &values) const {
+		std::vector<UInt> distinct(colIdxs);
+		std::sort(distinct.begin(), distinct.end());
+		distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+		size_t n = distinct.size();
+
+		// destinations, allocated by the calling thread: the vectors of
+		// plain fixed-width columns, and the payload buffers of other
+		// compressed columns not decompressed yet
+		std::vector<Vector> distinctValues(n);
+		std::vector<char *> pDest(n, (char *)0);
+		std::vector<size_t> destSize(n, 0), noBlocks(n, 0);
+		std::vector<Bool>   isPayload(n, false);
+		for (size_t i=0; i<n; i++) {
+			const TableFileColumn &column = m_Columns[distinct[i]-1];
+			ColumnState &state = m_States[distinct[i]-1];
+			const char *p = m_File.GetPtr() + column.Offset;
+			if (column.Encoding == VE_PLAIN && m_NoRecords && ColumnData::IsFixedWidth((DataType)column.DataType)) {
+				switch (column.DataType) {
+					case DT_BYTE:   pDest[i] = (char *)AllocValues<Byte>(distinctValues[i]); break;
+					case DT_INT:    pDest[i] = (char *)AllocValues<Int>(distinctValues[i]); break;
+					case DT_DOUBLE: pDest[i] = (char *)AllocValues<Double>(distinctValues[i]); break;
+					default:        break;
+				}
+				if (!pDest[i]) return false;
+				destSize[i] = (size_t)m_NoRecords * column.GetFilterWidth();
+				if (column.Codec != CC_NONE && !state.IsDecompressed &&
+					!BlockCompression::GetBlockCount(p, (size_t)column.Size, destSize[i], noBlocks[i])) return false;
+			} else if (column.Codec != CC_NONE && !state.IsDecompressed) {
+				// the size is checked before allocating, as it may be corrupt
+				unsigned long long rawSize;
+				if (!BlockCompression::GetRawSize(p, (size_t)column.Size, rawSize) || rawSize > (size_t)-1 ||
+					!BlockCompression::GetBlockCount(p, (size_t)column.Size, (size_t)rawSize, noBlocks[i])) return false;
+				state.Payload.resize((size_t)rawSize);
+				pDest[i]     = state.Payload.data();
+				destSize[i]  = (size_t)rawSize;
+				isPayload[i] = true;
+			}
+		}
+
+		// one work list of the blocks of all compressed columns and the
+		// copies of all uncompressed (or already decompressed) ones, so
+		// that the columns and their blocks share one parallel loop
+		std::vector<std::pair<size_t, size_t> > tasks; // column, block (NoBlock for copies)
+		for (size_t i=0; i<n; i++) {
+			if (!pDest[i]) continue;
+			const TableFileColumn &column = m_Columns[distinct[i]-1];
+			if (column.Codec == CC_NONE || (!isPayload[i] && m_States[distinct[i]-1].IsDecompressed)) {
+				tasks.push_back(std::make_pair(i, NoBlock));
+			} else {
+				for (size_t b=0; b<noBlocks[i]; b++) tasks.push_back(std::make_pair(i, b));
+			}
+		}
+		std::vector<char> isTaskValid(tasks.size(), false);
+		Parallel::For(0, tasks.size(), 1, [&](size_t t0, size_t t1) {
+			std::vector<unsigned char> scratch;
+			for (size_t t=t0; t<t1; t++) {
+				size_t i = tasks[t].first;
+				const TableFileColumn &column = m_Columns[distinct[i]-1];
+				if (tasks[t].second == NoBlock) {
+					// no allocation: the payload is mapped or has been decompressed before
+					const char *p = GetPayload(distinct[i]);
+					if (p) memcpy(pDest[i], p, destSize[i]);
+					isTaskValid[t] = p != 0;
+				} else {
+					isTaskValid[t] = BlockCompression::DecompressBlock(m_File.GetPtr() + column.Offset, column.GetFilterWidth(),
+						(CompressionCodec)column.Codec, pDest[i], destSize[i], tasks[t].second, scratch);
+				}
+			}
+		});
+		std::vector<Bool> isValid(n, true);
+		for (size_t t=0; t<tasks.size(); t++) {
+			if (!isTaskValid[t]) isValid[tasks[t].first] = false;
+		}
+
+		for (size_t i=0; i<n; i++) {
+			if (!isPayload[i]) continue;
+			ColumnState &state = m_States[distinct[i]-1];
+			state.IsDecompressed = true;
+			state.IsValid = isValid[i] && (m_Columns[distinct[i]-1].Encoding != VE_PLAIN || IsValidPayload(distinct[i], state.Payload.data(), state.Payload.size()));
+			if (!state.IsValid) std::vector<char>().swap(state.Payload);
+		}
+
+		// strings and encoded vectors are reference counted, so they are
+		// created by the calling thread
+		for (size_t i=0; i<n; i++) {
+			if (!isValid[i]) return false;
+			if (!pDest[i] || isPayload[i]) distinctValues[i] = GetValues(distinct[i]);
+			if (distinctValues[i].Len() != m_NoRecords) return false;
+		}
+		values.resize(colIdxs.size());
+		for (size_t c=0; c<colIdxs.size(); c++) {
+			values[c] = distinctValues[std::lower_bound(distinct.begin(), distinct.end(), colIdxs[c]) - distinct.begin()];
+		}
+		return true;
+	}
+
+	template<class T> T *AllocValues(Vector &v) const {
+		typename ColumnType<T>::VectorType tv;
+		T *p = ColumnData::Alloc<T>(tv, m_NoRecords);
+		v = tv;
+		return p;
+	}
+
+	template<class T> Value GetFixed(UInt colIdx, size_t i) const {
+		const T *p = GetColumnPtr<T>(colIdx);
+		return p ? Value(p[i]) : Value();
+	}
+
+	// returns a string of a column; corrupt offsets yield an empty string
+	String GetString(UInt colIdx, size_t i) const {
+		const unsigned long long *pOffsets = (const unsigned long long *)GetPayload(colIdx);
+		if (!pOffsets) return String();
+		const char *pChars = (const char *)(pOffsets + m_NoRecords + 1);
+		if (pOffsets[i] >= pOffsets[i+1] || pOffsets[i+1] > pOffsets[m_NoRecords]) return String();
+		return String(pChars + pOffsets[i], (size_t)(pOffsets[i+1] - pOffsets[i] - 1));
+	}
+
+	template<class T> Vector CopyFixed(UInt colIdx) const {
+		if (!m_NoRecords) return typename ColumnType<T>::VectorType();
+		const T *p = GetColumnPtr<T>(colIdx);
+		return p ? typename ColumnType<T>::VectorType(p, m_NoRecords) : Vector();
+	}
+
+	Vector CopyStrings(UInt colIdx) const {
+		if (!GetPayload(colIdx)) return Vector();
+		StringVector sv;
+		String *p = ColumnData::Alloc<String>(sv, m_NoRecords);
+		for (size_t i=0; p && i<m_NoRecords; i++) p[i] = GetString(colIdx, i);
+		return sv;
+	}
+
+	MappedFile                       m_File;
+	TableFileSchema                  m_Schema;
+	std::vector<TableFileColumn>     m_Columns;   // column directory
+	mutable std::vector<ColumnState> m_States;    // compressed and encoded columns, loaded on first access
+	UInt                             m_NoRecords; // number of records of the mapped file
+	ITableHandle                     m_Table;     // materialized table
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_MAPPEDTABLE_H_INCLUDED */
@@ -0,0 +1,62 @@
+#ifndef DCI_PARALLEL_H_INCLUDED
+#define DCI_PARALLEL_H_INCLUDED
+
+#include "DCI/DCI.h"
+
+#include <thread>
+#include <vector>
+
+namespace DCI {
+
+// {internal}
+// {group:Global Modules}
+// Description: Parallel Execution Module.
+//
+// Helper routines distributing independent pieces of work (ranges of
+// records, columns etc.) onto worker threads.
+class Parallel {
+public:
+	// Description:
+	// Returns the number of threads used for parallel execution.
+	static UInt GetThreadCount() {
+		UInt n = std::thread::hardware_concurrency();
+		return n ? n : 1;
+	}
+
+	// Description:
+	// Splits the range [first, last) into at most GetThreadCount()
+	// contiguous chunks of at least grain elements and calls
+	// f(chunkFirst, chunkLast) for every chunk. The chunks are processed
+	// in parallel; the calling thread processes the first chunk. The
+	// method returns after all chunks have been processed.
+	//
+	// Arguments:
+	// first - The first element of the range.
+	// last  - The element following the last element of the range.
+	// grain - The minimum number of elements per chunk.
+	// f     - The function object to be called for each chunk.
+	template<class F> static void For(size_t first, size_t last, size_t grain, F f) {
+		if (last <= first) return;
+		size_t n = last - first;
+		if (!grain) grain = 1;
+		size_t noChunks = (n + grain - 1) / grain;
+		if (noChunks > GetThreadCount()) noChunks = GetThreadCount();
+		if (noChunks <= 1) {
+			f(first, last);
+			return;
+		}
+		size_t chunkLen = (n + noChunks - 1) / noChunks;
+		std::vector<std::thread> threads;
+		threads.reserve(noChunks - 1);
+		for (size_t b = first + chunkLen; b < last; b += chunkLen) {
+			size_t e = (last - b < chunkLen) ? last : b + chunkLen;
+			threads.push_back(std::thread(f, b, e));
+		}
+		f(first, first + chunkLen);
+		for (size_t i=0; i<threads.size(); i++) threads[i].join();
+	}
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_PARALLEL_H_INCLUDED */
@@ -0,0 +1,202 @@
+#ifndef DCI_PREPAREDCOLUMNS_H_INCLUDED
+#define DCI_PREPAREDCOLUMNS_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+#include "DCI/SchemaFingerprint.h"
+
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Prepared Columns Class.
+//
+// A set of columns of a table whose keys are resolved once, so that
+// fields (cells) can be accessed by the position of the column within
+// the set instead of by key. This avoids a key lookup per access,
+// e.g. when reading many named columns for every record.
+//
+// The columns are resolved against a schema fingerprint (see
+// SchemaFingerprint). Every access compares the fingerprint to the one
+// seen when the columns were resolved, and resolves the columns again
+// if it has changed. The fingerprint is either supplied by the caller
+// (and kept up to date by whoever changes the schema) or owned by the
+// prepared columns. An owned fingerprint is only recomputed by
+// Validate, so schema changes are not noticed until Validate is called.
+//
+// Please note, that the prepared columns hold references to the
+// table's columns, which makes ITable::ReDim fail if it has to remove
+// one of them. Release the prepared columns (or prepare them for
+// another table) before removing columns.
+//
+// Example:
+//   StringVector keys;
+//   keys.ReDim(2); keys[0] = "Time"; keys[1] = "Concentration";
+//   PreparedColumns cols(hTable, keys);
+//   Double c;
+//   for (UInt r=1; r<=noRecs; r++) if (cols.Get(r, 2, c)) sum += c;
+class PreparedColumns {
+public:
+	// Description:
+	// Constructs a set of prepared columns.
+	//
+	// Arguments:
+	// hTable       - The handle of the table.
+	// colKeys      - The keys of the columns, in the order of their
+	//                positions within the set.
+	// pFingerprint - The schema fingerprint of the table, or NULL if
+	//                the prepared columns should own a fingerprint. The
+	//                fingerprint must outlive the prepared columns.
+	PreparedColumns() : m_pFingerprint(0), m_Version(0) {}
+	PreparedColumns(const ITableHandle &hTable, const StringVector &colKeys, const SchemaFingerprint *pFingerprint = 0) : m_pFingerprint(0), m_Version(0) {
+		Prepare(hTable, colKeys, pFingerprint);
+	}
+
+	// Description:
+	// Resolves a (possibly different) set of columns of a (possibly
+	// different) table. See the constructor for the arguments.
+	//
+	// Returns:
+	// true if all columns were found, or false otherwise. Columns not
+	// found have an empty handle.
+	Bool Prepare(const ITableHandle &hTable, const StringVector &colKeys, const SchemaFingerprint *pFingerprint = 0) {
+		m_Table = hTable;
+		m_Keys = colKeys;
+		m_pFingerprint = pFingerprint;
+		if (!m_pFingerprint) m_Fingerprint.Attach(hTable);
+		return Resolve();
+	}
+
+	// Description:
+	// Recomputes an owned fingerprint and resolves the columns again
+	// if the schema has changed. Call this method before a batch of
+	// accesses if the schema may have been changed by other code.
+	//
+	// Returns:
+	// true if all columns are resolved, or false otherwise.
+	Bool Validate() {
+		if (!m_pFingerprint) m_Fingerprint.Refresh();
+		return IsCurrent() ? IsComplete() : Resolve();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of columns of the set.
+	UInt GetCount() const {
+		return (UInt)m_Columns.size();
+	}
+
+	// Description:
+	// Returns the position of a column within the set.
+	//
+	// Arguments:
+	// colKey - Key associated with the column.
+	//
+	// Returns:
+	// The position (1-based), or 0 if the column is not part of the set.
+	UInt IndexOf(const String &colKey) const {
+		for (size_t i=0; i<m_Keys.Len(); i++) {
+			if (m_Keys[i] == colKey) return (UInt)i + 1;
+		}
+		return 0;
+	}
+
+	// Description:
+	// Returns a column of the set.
+	//
+	// Arguments:
+	// colPos - Position of the column within the set (1-based).
+	IVariableHandle GetColumn(UInt colPos) {
+		Check();
+		return (colPos >= 1 && colPos <= m_Columns.size()) ? m_Columns[colPos-1] : IVariableHandle();
+	}
+
+	// Description:
+	// Returns the value of a field (cell) (see IVariable::GetValue).
+	// The typed version gets the value as the specified type (Byte,
+	// Int, Double or String); it does not convert the value, but fails
+	// if the value has a different data type (e.g. for a missing field).
+	//
+	// Arguments:
+	// recIdx - Index of the record. The index of the first record is 1.
+	// colPos - Position of the column within the set (1-based).
+	// value  - Receives the value.
+	//
+	// Returns:
+	// The value of the field, or, for the typed version, true if the
+	// value has the specified data type, or false otherwise.
+	Value GetValue(UInt recIdx, UInt colPos) {
+		IVariable *pCol = Item(colPos);
+		return pCol ? pCol->GetValue(recIdx) : Value();
+	}
+	template<class T> Bool Get(UInt recIdx, UInt colPos, T &value) {
+		Value v = GetValue(recIdx, colPos);
+		if (v.GetDataType() != ColumnType<T>::GetDataType()) return false;
+		value = v.operator T();
+		return true;
+	}
+
+	// Description:
+	// Sets the value of a field (cell) (see IVariable::SetValue).
+	//
+	// Arguments:
+	// recIdx   - Index of the record. The index of the first record is 1.
+	// colPos   - Position of the column within the set (1-based).
+	// newValue - The new value.
+	//
+	// Returns:
+	// true if the method succeeds, or false otherwise.
+	Bool SetValue(UInt recIdx, UInt colPos, const Value &newValue) {
+		IVariable *pCol = Item(colPos);
+		return pCol && pCol->SetValue(recIdx, newValue);
+	}
+	template<class T> Bool Set(UInt recIdx, UInt colPos, const T &newValue) {
+		return SetValue(recIdx, colPos, Value(newValue));
+	}
+
+private:
+	const SchemaFingerprint &GetFingerprint() const {
+		return m_pFingerprint ? *m_pFingerprint : m_Fingerprint;
+	}
+
+	Bool IsCurrent() const {
+		return m_Version == GetFingerprint().GetValue();
+	}
+
+	Bool IsComplete() const {
+		for (size_t i=0; i<m_Columns.size(); i++) {
+			if (!m_Columns[i]) return false;
+		}
+		return true;
+	}
+
+	Bool Resolve() {
+		m_Version = GetFingerprint().GetValue();
+		m_Columns.assign(m_Keys.Len(), IVariableHandle());
+		if (!m_Table) return false;
+		for (size_t i=0; i<m_Keys.Len(); i++) m_Columns[i] = m_Table->GetColumn(m_Keys[i]);
+		return IsComplete();
+	}
+
+	void Check() {
+		if (!IsCurrent()) Resolve();
+	}
+
+	IVariable *Item(UInt colPos) {
+		Check();
+		return (colPos >= 1 && colPos <= m_Columns.size()) ? m_Columns[colPos-1].GetPtr() : 0;
+	}
+
+	ITableHandle                 m_Table;
+	StringVector                 m_Keys;
+	std::vector<IVariableHandle> m_Columns;      // resolved columns
+	const SchemaFingerprint     *m_pFingerprint; // supplied fingerprint, or NULL
+	SchemaFingerprint            m_Fingerprint;  // owned fingerprint
+	unsigned long long           m_Version;      // fingerprint seen by Resolve
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_PREPAREDCOLUMNS_H_INCLUDED */
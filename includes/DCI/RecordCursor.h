@@ -0,0 +1,184 @@
+#ifndef DCI_RECORDCURSOR_H_INCLUDED
+#define DCI_RECORDCURSOR_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Record Cursor Class.
+//
+// A record cursor is a lightweight, reusable proxy for the records
+// (rows) of a table. Unlike IRecord objects, a cursor is not a
+// reference counted heap object: it is created on the stack, resolves
+// the table's columns once and is then moved from record to record.
+// The number of records is computed from the column lengths, so
+// walking a table with a cursor never touches the table's record
+// collection.
+//
+// If a real record object is needed (e.g. to pass it to an API
+// expecting an IRecordHandle), GetRecord creates it on demand for the
+// current position only.
+//
+// Please note, that the cursor holds references to the table's columns.
+// Release the cursor (or attach it to another table) before removing
+// columns, and call Attach again after columns have been added.
+class RecordCursor {
+public:
+	// Description:
+	// Constructs a new cursor positioned at the specified record.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be walked.
+	// recIdx - Index of the initial record. The index of the first
+	//          record is 1.
+	RecordCursor() : m_Index(0) {}
+	RecordCursor(ITableHandle &hTable, UInt recIdx = 1) : m_Index(0) {
+		Attach(hTable, recIdx);
+	}
+
+	// Description:
+	// Binds the cursor to a (possibly different) table and positions
+	// it at the specified record. The table's columns are resolved once.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be walked.
+	// recIdx - Index of the initial record. The index of the first
+	//          record is 1.
+	void Attach(ITableHandle &hTable, UInt recIdx = 1) {
+		m_Table = hTable;
+		m_Columns.clear();
+		if (m_Table) {
+			IVariablesHandle hCols = m_Table->GetColumns();
+			m_Columns.resize(hCols->GetCount());
+			for (UInt i=0; i<m_Columns.size(); i++) m_Columns[i] = hCols->Item(i+1);
+		}
+		m_Index = recIdx;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of records of the table, computed from
+	// the length of its columns.
+	UInt GetRecordCount() const {
+		return m_Columns.empty() ? 0 : m_Columns[0]->GetLength();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the index of the current record. The index of the first
+	// record is 1.
+	UInt GetIndex() const {
+		return m_Index;
+	}
+
+	// Description:
+	// Moves the cursor to the specified record.
+	//
+	// Arguments:
+	// recIdx - Index of the record. The index of the first record is 1.
+	//
+	// Returns:
+	// true if the cursor points to a valid record, or false otherwise.
+	Bool MoveTo(UInt recIdx) {
+		m_Index = recIdx;
+		return !IsEOF();
+	}
+
+	// Description:
+	// Moves the cursor to the next record.
+	//
+	// Returns:
+	// true if the cursor points to a valid record, or false otherwise.
+	Bool MoveNext() {
+		m_Index++;
+		return !IsEOF();
+	}
+
+	// Description:
+	// Tests if the cursor is positioned outside of the table.
+	Bool IsEOF() const {
+		return m_Index < 1 || m_Index > GetRecordCount();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the table the cursor is bound to.
+	ITableHandle GetTable() const {
+		return m_Table;
+	}
+
+	// {group:Read/Write Properties}
+	// Description:
+	// Returns the value of a field of the current record.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	// colKey - Key associated with the column.
+	//
+	// Returns:
+	// The value of the field, or a void value if the column does not
+	// exist.
+	Value GetValue(UInt colIdx) const {
+		if (colIdx < 1 || colIdx > m_Columns.size()) return Value();
+		return m_Columns[colIdx-1]->GetValue(m_Index);
+	}
+	Value GetValue(const String &colKey) const {
+		return GetValue(m_Table ? m_Table->GetColumns()->IndexOf(colKey) : 0);
+	}
+
+	// {group:Read/Write Properties}
+	// Description:
+	// Sets the value of a field of the current record.
+	//
+	// Arguments:
+	// colIdx   - Index of the column. The index of the first column is 1.
+	// colKey   - Key associated with the column.
+	// newValue - The new value of the field.
+	//
+	// Returns:
+	// true, if the new value is accepted, or false otherwise.
+	Bool SetValue(UInt colIdx, const Value &newValue) {
+		if (colIdx < 1 || colIdx > m_Columns.size()) return false;
+		return m_Columns[colIdx-1]->SetValue(m_Index, newValue);
+	}
+	Bool SetValue(const String &colKey, const Value &newValue) {
+		return SetValue(m_Table ? m_Table->GetColumns()->IndexOf(colKey) : 0, newValue);
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the field values of the current record.
+	//
+	// Returns:
+	// The value vector of the record.
+	ValueVector GetValues() const {
+		ValueVector values;
+		values.ReDim(m_Columns.size());
+		for (UInt i=0; i<m_Columns.size(); i++) values[i] = m_Columns[i]->GetValue(m_Index);
+		return values;
+	}
+
+	// Description:
+	// Creates a record object for the current record. Use this method
+	// only, if an IRecord interface is really needed.
+	//
+	// Returns:
+	// The handle of the record if the cursor points to a valid record,
+	// or an unbound handle otherwise.
+	IRecordHandle GetRecord() const {
+		return IsEOF() ? IRecordHandle() : m_Table->GetRecord(m_Index);
+	}
+
+private:
+	ITableHandle                 m_Table;
+	std::vector<IVariableHandle> m_Columns;
+	UInt                         m_Index;
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_RECORDCURSOR_H_INCLUDED */
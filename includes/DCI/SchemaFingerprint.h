@@ -0,0 +1,223 @@
+#ifndef DCI_SCHEMAFINGERPRINT_H_INCLUDED
+#define DCI_SCHEMAFINGERPRINT_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/ColumnData.h"
+
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Schema Fingerprint Class.
+//
+// A schema fingerprint is a 64-bit hash of the schema of a table: the
+// key, data type, minimum, maximum, default and allowed values of every
+// field definition, together with its position. Two tables with equal
+// fingerprints have the same schema (with overwhelming probability),
+// so comparing fingerprints replaces comparing field definitions one
+// by one.
+//
+// The fingerprint keeps the hash of every column, combined such that
+// a column's contribution can be replaced: after changing a field
+// definition, call Update for that column instead of recomputing the
+// whole fingerprint. Field definitions changed without calling Update
+// are only noticed by Refresh.
+class SchemaFingerprint {
+public:
+	// Description:
+	// Constructs the fingerprint of a table.
+	//
+	// Arguments:
+	// hTable - The handle of the table.
+	SchemaFingerprint() : m_Value(0) {}
+	SchemaFingerprint(const ITableHandle &hTable) : m_Value(0) {
+		Attach(hTable);
+	}
+
+	// Description:
+	// Binds the fingerprint to a (possibly different) table and
+	// computes it.
+	void Attach(const ITableHandle &hTable) {
+		m_Table = hTable;
+		Refresh();
+	}
+
+	// Description:
+	// Recomputes the fingerprint from all field definitions.
+	void Refresh() {
+		m_Columns.clear();
+		m_Value = 0;
+		if (!m_Table) return;
+		IFieldDefsHandle hDefs = m_Table->GetFieldDefs();
+		m_Columns.resize(hDefs->GetCount());
+		for (UInt c=1; c<=m_Columns.size(); c++) {
+			m_Columns[c-1] = Combine(c, GetHash(hDefs->KeyOf(c), hDefs->Item(c)));
+			m_Value ^= m_Columns[c-1];
+		}
+	}
+
+	// Description:
+	// Updates the fingerprint after the field definition of a column
+	// has changed. If columns were added or removed, the fingerprint
+	// is recomputed.
+	//
+	// Arguments:
+	// colIdx - Index of the column. The index of the first column is 1.
+	// colKey - Key associated with the column.
+	void Update(UInt colIdx) {
+		if (!m_Table) return;
+		IFieldDefsHandle hDefs = m_Table->GetFieldDefs();
+		if (hDefs->GetCount() != m_Columns.size()) {
+			Refresh();
+			return;
+		}
+		if (colIdx < 1 || colIdx > m_Columns.size()) return;
+		m_Value ^= m_Columns[colIdx-1];
+		m_Columns[colIdx-1] = Combine(colIdx, GetHash(hDefs->KeyOf(colIdx), hDefs->Item(colIdx)));
+		m_Value ^= m_Columns[colIdx-1];
+	}
+	void Update(const String &colKey) {
+		if (m_Table) Update(m_Table->GetFieldDefs()->IndexOf(colKey));
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the fingerprint.
+	unsigned long long GetValue() const {
+		return m_Value;
+	}
+
+	// Description:
+	// Tests if two fingerprints are equal.
+	friend bool operator == (const SchemaFingerprint &f1, const SchemaFingerprint &f2) { return f1.m_Value == f2.m_Value; }
+	friend bool operator != (const SchemaFingerprint &f1, const SchemaFingerprint &f2) { return f1.m_Value != f2.m_Value; }
+
+	// Description:
+	// Computes the fingerprint of a table.
+	//
+	// Arguments:
+	// hTable - The handle of the table.
+	//
+	// Returns:
+	// The fingerprint of the table's schema.
+	static unsigned long long Compute(const ITableHandle &hTable) {
+		return SchemaFingerprint(hTable).GetValue();
+	}
+
+	// Description:
+	// Assigns the schema of a source table to a table unless both
+	// tables already have the same schema (see ITable::AssignSchemaFrom).
+	//
+	// The first form computes the fingerprints of both tables, which
+	// takes time proportional to the size of their schemas. The second
+	// form compares the fingerprints bound to the tables in constant
+	// time; they must be up to date (see Update). If the schema is
+	// assigned, the fingerprint of the table is set to the one of the
+	// source table.
+	//
+	// Please note, that AssignSchemaFrom removes all values of the
+	// table; if the schemas are equal, the table is left unchanged.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be assigned to.
+	// srcTbl - The handle of the source table.
+	// target - The fingerprint bound to the table to be assigned to.
+	// source - The fingerprint bound to the source table.
+	//
+	// Returns:
+	// true, if the schemas were equal or the schema was assigned, or
+	// false otherwise (also if a fingerprint is not bound to a table).
+	// In order to get extended error information, please make use of
+	// the Error module.
+	static Bool AssignSchemaIfChanged(ITableHandle &hTable, ITableHandle &srcTbl) {
+		if (Compute(hTable) == Compute(srcTbl)) return true;
+		return hTable->AssignSchemaFrom(srcTbl);
+	}
+	static Bool AssignSchemaIfChanged(SchemaFingerprint &target, const SchemaFingerprint &source) {
+		if (target == source) return true;
+		if (!target.m_Table || !source.m_Table) return false;
+		ITableHandle srcTbl = source.m_Table;
+		if (!target.m_Table->AssignSchemaFrom(srcTbl)) return false;
+		target.m_Value   = source.m_Value;
+		target.m_Columns = source.m_Columns;
+		return true;
+	}
+
+private:
+	// FNV-1a, 64 bit
+	static void Hash(unsigned long long &h, const void *p, size_t Len) {
+		const unsigned char *pc = (const unsigned char *)p;
+		for (size_t i=0; i<Len; i++) {
+			h ^= pc[i];
+			h *= 0x100000001b3ULL;
+		}
+	}
+	static void Hash(unsigned long long &h, const String &s) {
+		Hash(h, (const char *)s, s.Len() + 1);
+	}
+	// hashes fixed-width values only, so that x86 and x64 builds agree
+	static void Hash(unsigned long long &h, DataType dt) {
+		Int type = dt;
+		Hash(h, &type, sizeof(type));
+	}
+	static void Hash(unsigned long long &h, const Value &v) {
+		DataType dt = v.GetDataType();
+		Hash(h, dt);
+		switch (ColumnData::GetStorageType(dt)) {
+			case DT_BYTE:   { Byte b = v;   Hash(h, &b, sizeof(b)); break; }
+			case DT_INT:    { Int i = v;    Hash(h, &i, sizeof(i)); break; }
+			case DT_DOUBLE: { Double d = v; Hash(h, &d, sizeof(d)); break; }
+			case DT_STRING: Hash(h, v.operator String()); break;
+			default:        break;
+		}
+	}
+	static void Hash(unsigned long long &h, const Vector &v) {
+		DataType dt = v.GetDataType();
+		size_t Len = v.Len();
+		unsigned long long len = Len;
+		Hash(h, dt);
+		Hash(h, &len, sizeof(len));
+		if (!Len) return;
+		if (ColumnData::IsFixedWidth(dt)) {
+			Hash(h, ColumnData::GetDataPtr(v), Len * ColumnData::GetElementSize(dt));
+		} else if (dt == DT_STRING) {
+			const String *p = StringVector(v).GetPtr();
+			for (size_t i=0; i<Len; i++) Hash(h, p[i]);
+		} else if (dt == DT_VALUE) {
+			const Value *p = ValueVector(v).GetPtr();
+			for (size_t i=0; i<Len; i++) Hash(h, p[i]);
+		}
+	}
+
+	static unsigned long long GetHash(const String &colKey, const IFieldDefHandle &hDef) {
+		unsigned long long h = 0xcbf29ce484222325ULL;
+		Hash(h, colKey);
+		Hash(h, hDef->GetDataType());
+		Hash(h, hDef->GetMinValue());
+		Hash(h, hDef->GetMaxValue());
+		Hash(h, hDef->GetDefaultValue());
+		Hash(h, hDef->GetAllowedValues());
+		return h;
+	}
+
+	// mixes the column's position into its hash (splitmix64 finalizer),
+	// so that the XOR of all columns depends on the column order
+	static unsigned long long Combine(UInt colIdx, unsigned long long h) {
+		h += 0x9e3779b97f4a7c15ULL * colIdx;
+		h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+		h ^= h >> 31;
+		return h;
+	}
+
+	ITableHandle                    m_Table;
+	unsigned long long              m_Value;   // XOR of m_Columns
+	std::vector<unsigned long long> m_Columns; // combined hash per column
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_SCHEMAFINGERPRINT_H_INCLUDED */
@@ -0,0 +1,365 @@
+#ifndef DCI_SPARSEVECTOR_H_INCLUDED
+#define DCI_SPARSEVECTOR_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/BinaryBuffer.h"
+#include "DCI/ColumnData.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Sparse Vector Class.
+//
+// A sparse vector stores the values of a column in which most values
+// equal a default value (typically the default value of the column's
+// field definition): only the default value and a sorted list of
+// exceptions, i.e. (index, value) pairs of the elements differing from
+// the default value, are stored.
+//
+// Sparse vectors are built from (and converted to) ordinary vectors
+// of byte, integer, double or string values; IsSparse decides by the
+// density of the exceptions whether the sparse representation pays
+// off. Elements are indexed from 0, as with Vector. The indexes of the
+// exceptions are stored as integers, so the length of a sparse vector is
+// limited to MaxLen elements.
+class SparseVector {
+public:
+	enum {
+		DefaultMaxDensity = 5 // default maximum density of exceptions (percent) for IsSparse
+	};
+
+	// maximum length of a sparse vector (the largest index must be an Int)
+	static const unsigned long long MaxLen = 0x80000000ULL;
+
+	// Description:
+	// Constructs a sparse vector.
+	//
+	// Arguments:
+	// v            - The (dense) vector to be represented.
+	// defaultValue - The default value. It is converted to the data
+	//                type of the vector; a void value stands for the
+	//                missing value (BYTE_NAN, INT_NAN, NaN or an empty
+	//                string).
+	// fp           - The file pointer of a file storing a sparse vector
+	//                (see SaveToBinaryFile).
+	SparseVector() : m_Type(DT_VOID), m_Len(0) {}
+	SparseVector(const Vector &v, const Value &defaultValue = Value()) : m_Type(DT_VOID), m_Len(0) {
+		Assign(v, defaultValue);
+	}
+	SparseVector(FILE *fp) : m_Type(DT_VOID), m_Len(0) {
+		LoadFromBinaryFile(fp);
+	}
+
+	// Description:
+	// Builds the sparse representation of a vector or of the values of
+	// a column. The default value of a column is the default value of
+	// its field definition.
+	//
+	// Arguments:
+	// v            - The (dense) vector to be represented.
+	// defaultValue - The default value (see the constructor).
+	// hVariable    - The column.
+	//
+	// Returns:
+	// true if the method succeeds, or false if the data type of the
+	// vector is not supported or the vector is longer than MaxLen.
+	Bool Assign(const Vector &v, const Value &defaultValue = Value()) {
+		m_Type = v.Len() ? v.GetDataType() : DT_VOID;
+		m_Len  = v.Len();
+		m_Rows = IntVector();
+		m_Values = Vector();
+		if (m_Len > MaxLen) {
+			m_Type = DT_VOID;
+			m_Len  = 0;
+			return false;
+		}
+		switch (m_Type) {
+			case DT_VOID:   m_Default = Value(); return true;
+			case DT_BYTE:   return AssignTyped<Byte>(v, defaultValue);
+			case DT_INT:    return AssignTyped<Int>(v, defaultValue);
+			case DT_DOUBLE: return AssignTyped<Double>(v, defaultValue);
+			case DT_STRING: return AssignTyped<String>(v, defaultValue);
+			default:
+				m_Type = DT_VOID;
+				m_Len  = 0;
+				return false;
+		}
+	}
+	Bool Assign(const IVariableHandle &hVariable) {
+		return Assign(hVariable->GetValues(), hVariable->GetFieldDef()->GetDefaultValue());
+	}
+
+	// Description:
+	// Converts the sparse vector to an ordinary (dense) vector.
+	Vector ToVector() const {
+		switch (m_Type) {
+			case DT_BYTE:   return ToVectorTyped<Byte>();
+			case DT_INT:    return ToVectorTyped<Int>();
+			case DT_DOUBLE: return ToVectorTyped<Double>();
+			case DT_STRING: return ToVectorTyped<String>();
+			default:        return Vector();
+		}
+	}
+
+	// Description:
+	// Assigns the (dense) values of the sparse vector to a column
+	// (see IVariable::SetValues).
+	Bool Store(IVariableHandle &hVariable) const {
+		return hVariable->SetValues(ToVector());
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the length of the (dense) vector.
+	size_t Len() const {
+		return m_Len;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the data type of the elements.
+	DataType GetDataType() const {
+		return m_Type;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the default value, converted to the data type of the
+	// elements.
+	const Value &GetDefaultValue() const {
+		return m_Default;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of elements differing from the default value.
+	size_t GetExceptionCount() const {
+		return m_Rows.Len();
+	}
+
+	// Description:
+	// Returns an element.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	//
+	// Returns:
+	// The value of the element, or a void value if the index is out of
+	// range.
+	Value GetValue(size_t Index) const {
+		if (Index >= m_Len) return Value();
+		size_t n = m_Rows.Len();
+		if (!n) return m_Default;
+		const Int *pRows = m_Rows.GetPtr();
+		const Int *p = std::lower_bound(pRows, pRows + n, (Int)Index);
+		if (p == pRows + n || *p != (Int)Index) return m_Default;
+		return ColumnData::GetValue(m_Values, p - pRows);
+	}
+
+	// Description:
+	// Returns the fraction of the elements of a vector differing from a
+	// default value (see the constructor).
+	static Double GetDensity(const Vector &v, const Value &defaultValue = Value()) {
+		if (!v.Len()) return 0.0;
+		switch (v.GetDataType()) {
+			case DT_BYTE:   return (Double)CountExceptions<Byte>(v, defaultValue) / v.Len();
+			case DT_INT:    return (Double)CountExceptions<Int>(v, defaultValue) / v.Len();
+			case DT_DOUBLE: return (Double)CountExceptions<Double>(v, defaultValue) / v.Len();
+			case DT_STRING: return (Double)CountExceptions<String>(v, defaultValue) / v.Len();
+			default:        return 1.0;
+		}
+	}
+
+	// Description:
+	// Tests if the sparse representation should be used for a vector,
+	// i.e. if at most the specified percentage of its elements differ
+	// from the default value.
+	//
+	// Arguments:
+	// v            - The (dense) vector.
+	// defaultValue - The default value (see the constructor).
+	// maxDensity   - The maximum percentage of exceptions.
+	static Bool IsSparse(const Vector &v, const Value &defaultValue = Value(), Double maxDensity = DefaultMaxDensity) {
+		return v.Len() && GetDensity(v, defaultValue) * 100.0 <= maxDensity;
+	}
+
+	// Description:
+	// Saves the sparse vector to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		Int type = m_Type;
+		unsigned long long len = m_Len;
+		return fwrite(&type, sizeof(type), 1, fp) == 1 && fwrite(&len, sizeof(len), 1, fp) == 1 &&
+			m_Default.SaveToBinaryFile(fp) && m_Rows.SaveToBinaryFile(fp) && m_Values.SaveToBinaryFile(fp);
+	}
+
+	// Description:
+	// Loads a sparse vector from a binary file written by
+	// SaveToBinaryFile.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		Int type;
+		unsigned long long len;
+		if (fread(&type, sizeof(type), 1, fp) != 1 || fread(&len, sizeof(len), 1, fp) != 1) return false;
+		// check the header before allocating, as it may be corrupt
+		if (!IsValidHeader(type, len)) {
+			Assign(Vector());
+			return false;
+		}
+		m_Type    = (DataType)type;
+		m_Len     = (size_t)len;
+		m_Default = Value(fp);
+		Vector rows(fp);
+		m_Values  = Vector(fp);
+		if (ferror(fp) || (rows.Len() && rows.GetDataType() != DT_INT)) {
+			Assign(Vector());
+			return false;
+		}
+		m_Rows = IntVector(rows);
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Appends the sparse vector to a buffer, e.g. in order to store it
+	// in a table file (see TableFile).
+	//
+	// Arguments:
+	// w - The writer appending to the buffer.
+	void SaveToBuffer(BinaryWriter &w) const {
+		w.Put((Int)m_Type);
+		w.Put((unsigned long long)m_Len);
+		w.Put(m_Default);
+		w.Put(m_Rows);
+		w.Put(m_Values);
+	}
+
+	// Description:
+	// Loads a sparse vector from a buffer written by SaveToBuffer.
+	//
+	// Arguments:
+	// r - The reader of the buffer.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBuffer(BinaryReader &r) {
+		Int type;
+		unsigned long long len;
+		Vector rows;
+		if (!r.Get(type) || !r.Get(len) || !IsValidHeader(type, len) || !r.Get(m_Default) || !r.Get(rows) || !r.Get(m_Values) ||
+			(rows.Len() && rows.GetDataType() != DT_INT)) {
+			Assign(Vector());
+			return false;
+		}
+		m_Type = (DataType)type;
+		m_Len  = (size_t)len;
+		m_Rows = IntVector(rows);
+		if (!IsValid()) {
+			Assign(Vector());
+			return false;
+		}
+		return true;
+	}
+
+private:
+	template<class T> static T GetDefault(const Value &defaultValue) {
+		return defaultValue.GetDataType() == DT_VOID ? ColumnType<T>::GetMissing() : defaultValue.operator T();
+	}
+
+	template<class T> static size_t CountExceptions(const Vector &v, const Value &defaultValue) {
+		T def = GetDefault<T>(defaultValue);
+		const T *p = ColumnData::GetPtr<T>(v);
+		size_t n = 0;
+		for (size_t i=0; i<v.Len(); i++) {
+			if (!ColumnData::IsIdentical(p[i], def)) n++;
+		}
+		return n;
+	}
+
+	template<class T> Bool AssignTyped(const Vector &v, const Value &defaultValue) {
+		T def = GetDefault<T>(defaultValue);
+		m_Default = Value(def);
+		size_t n = CountExceptions<T>(v, defaultValue);
+		const T *p = ColumnData::GetPtr<T>(v);
+		typename ColumnType<T>::VectorType values;
+		Int *pRows = ColumnData::Alloc<Int>(m_Rows, n);
+		T *pValues = ColumnData::Alloc<T>(values, n);
+		if (n && (!pRows || !pValues)) return false;
+		for (size_t i=0, j=0; i<m_Len; i++) {
+			if (ColumnData::IsIdentical(p[i], def)) continue;
+			pRows[j]   = (Int)i;
+			pValues[j] = p[i];
+			j++;
+		}
+		m_Values = values;
+		return true;
+	}
+
+	template<class T> Vector ToVectorTyped() const {
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, m_Len);
+		if (!p) return v;
+		T def = m_Default.operator T();
+		for (size_t i=0; i<m_Len; i++) p[i] = def;
+		size_t n = m_Rows.Len();
+		if (n) {
+			const Int *pRows = m_Rows.GetPtr();
+			const T *pValues = ColumnData::GetPtr<T>(m_Values);
+			for (size_t j=0; j<n; j++) p[pRows[j]] = pValues[j];
+		}
+		return v;
+	}
+
+	// checks the data type and length of a loaded sparse vector; only
+	// empty vectors have no data type
+	static Bool IsValidHeader(Int type, unsigned long long len) {
+		if (len > MaxLen) return false;
+		switch (type) {
+			case DT_VOID:   return len == 0;
+			case DT_BYTE:
+			case DT_INT:
+			case DT_DOUBLE:
+			case DT_STRING: return len != 0;
+			default:        return false;
+		}
+	}
+
+	// checks the consistency of a loaded sparse vector
+	Bool IsValid() const {
+		size_t n = m_Rows.Len();
+		if (m_Default.GetDataType() != DT_VOID && m_Default.GetDataType() != m_Type) return false;
+		if (m_Values.Len() != n || (n && m_Values.GetDataType() != m_Type)) return false;
+		for (size_t j=0; j<n; j++) {
+			Int row = m_Rows.GetPtr()[j];
+			if (row < 0 || (size_t)row >= m_Len || (j && row <= m_Rows.GetPtr()[j-1])) return false;
+		}
+		return true;
+	}
+
+	DataType  m_Type;    // data type of the elements
+	size_t    m_Len;     // length of the dense vector
+	Value     m_Default; // default value, converted to m_Type
+	IntVector m_Rows;    // indexes of the exceptions, ascending
+	Vector    m_Values;  // values of the exceptions
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_SPARSEVECTOR_H_INCLUDED */
@@ -0,0 +1,314 @@
+#ifndef DCI_TABLEAGGREGATION_H_INCLUDED
+#define DCI_TABLEAGGREGATION_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/Error.h"
+#include "DCI/ColumnData.h"
+#include "DCI/KeyTable.h"
+#include "DCI/Parallel.h"
+#include "DCI/TableOperations.h"
+
+#include <vector>
+
+namespace DCI {
+
+// {group:Enumeration Types}
+// Description: Aggregate Functions.
+enum AggregateFunction {
+	AF_COUNT = 1, // Number of records of the group.
+	AF_SUM   = 2, // Sum of the (non-missing) values.
+	AF_MEAN  = 3, // Arithmetic mean of the (non-missing) values.
+	AF_MIN   = 4, // Minimum of the (non-missing) values.
+	AF_MAX   = 5, // Maximum of the (non-missing) values.
+	AF_FIRST = 6, // First (non-missing) value in record order.
+	AF_LAST  = 7  // Last (non-missing) value in record order.
+};
+
+// {group:Data Classes}
+// Description: Aggregate Specification.
+//
+// Specifies one aggregate column of the result of
+// TableAggregation::GroupBy.
+struct AggregateSpec {
+	String            ColumnKey; // Key of the aggregated (numeric) column; ignored for AF_COUNT.
+	AggregateFunction Function;  // The aggregate function.
+	String            ResultKey; // Key of the result column; if empty, e.g. "Mean(ColumnKey)" is used.
+
+	AggregateSpec() : Function(AF_COUNT) {}
+	AggregateSpec(const String &columnKey, AggregateFunction function, const String &resultKey = String())
+		: ColumnKey(columnKey), Function(function), ResultKey(resultKey) {}
+};
+
+// {group:Global Modules}
+// Description: Table Aggregation Module.
+//
+// The table aggregation module groups the records of a table by the
+// values of key columns and computes aggregates (count, sum, mean,
+// min, max, first, last) of other columns per group.
+class TableAggregation {
+public:
+	// Description:
+	// Groups the records of a record-based table and aggregates them.
+	//
+	// The key columns may have any data type except DT_VALUE; string
+	// keys are dictionary-encoded first, so that all keys are hashed as
+	// integers. Missing key values form a group of their own. The
+	// records are split into contiguous ranges which are aggregated on
+	// multiple threads, each thread building its own partial groups;
+	// the partial results are merged in record order.
+	//
+	// The result table has one record per distinct key combination, in
+	// order of the groups' first occurrence. Its first columns are the
+	// key columns (with the field definitions of the source table),
+	// followed by one column per aggregate specification: AF_COUNT
+	// yields an integer column, AF_SUM and AF_MEAN yield double columns,
+	// and AF_MIN, AF_MAX, AF_FIRST and AF_LAST yield columns with the
+	// data type of the aggregated column. Missing values of aggregated
+	// columns are ignored; if a group has no non-missing value, the
+	// aggregate is missing.
+	//
+	// Arguments:
+	// hTable  - The handle of the table to be aggregated.
+	// keyCols - The keys of the columns to be grouped by.
+	// specs   - Array of aggregate specifications.
+	// noSpecs - Number of elements of specs.
+	//
+	// Returns:
+	// The result table, or an empty handle in case of an error (e.g.
+	// if an aggregated column is not numeric). In order to get extended
+	// error information, please make use of the Error module.
+	static ITableHandle GroupBy(ITableHandle &hTable, const StringVector &keyCols, const AggregateSpec *specs, UInt noSpecs) {
+		if (!hTable->GetRecordBased()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The table must be record-based.");
+			return ITableHandle();
+		}
+		IVariablesHandle hCols = hTable->GetColumns();
+		size_t noRecs = hCols->GetCount() ? hCols->Item(1)->GetLength() : 0;
+		size_t noKeys = keyCols.Len();
+
+		// resolve the key columns; string keys are replaced by dictionary codes
+		std::vector<Vector> values;
+		std::vector<Column> keys(noKeys);
+		std::vector<IntVector> codes(noKeys);
+		for (size_t k=0; k<noKeys; k++) {
+			IVariableHandle hCol = hTable->GetColumn(keyCols[k]);
+			if (!hCol) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "There's no column with the specified key: " + keyCols[k]);
+				return ITableHandle();
+			}
+			Vector v = hCol->GetValues();
+			if (v.GetDataType() == DT_STRING) {
+				KeyTable::Dictionary dict;
+				codes[k] = KeyTable::Encode(StringVector(v), dict, true);
+				v = codes[k];
+			}
+			if (!KeyTable::GetColumn(v, keys[k])) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "Key columns of this data type are not supported: " + keyCols[k]);
+				return ITableHandle();
+			}
+			values.push_back(v);
+		}
+
+		// resolve the aggregated columns
+		std::vector<Column> aggs(noSpecs);
+		std::vector<DataType> aggTypes(noSpecs);
+		for (UInt s=0; s<noSpecs; s++) {
+			aggTypes[s] = DT_INT;
+			if (specs[s].Function == AF_COUNT) continue;
+			IVariableHandle hCol = hTable->GetColumn(specs[s].ColumnKey);
+			if (!hCol) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "There's no column with the specified key: " + specs[s].ColumnKey);
+				return ITableHandle();
+			}
+			Vector v = hCol->GetValues();
+			if (!KeyTable::GetColumn(v, aggs[s])) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "Aggregated columns must have a numeric data type: " + specs[s].ColumnKey);
+				return ITableHandle();
+			}
+			aggTypes[s] = (specs[s].Function == AF_SUM || specs[s].Function == AF_MEAN) ? DT_DOUBLE : hCol->GetFieldDef()->GetDataType();
+			values.push_back(v);
+		}
+
+		// partial aggregation of contiguous record ranges, one per thread
+		size_t noChunks = noRecs ? (noRecs + GrainSize - 1) / GrainSize : 0;
+		if (noChunks > Parallel::GetThreadCount()) noChunks = Parallel::GetThreadCount();
+		std::vector<Groups> partials(noChunks, Groups(noKeys, noSpecs));
+		Parallel::For(0, noChunks, 1, [&](size_t c0, size_t c1) {
+			for (size_t c=c0; c<c1; c++) {
+				partials[c].Aggregate(keys, specs, aggs, noRecs * c / noChunks, noRecs * (c + 1) / noChunks);
+			}
+		});
+
+		// merge in record order, so that the groups are ordered by their first occurrence
+		Groups result(noKeys, noSpecs);
+		for (size_t c=0; c<noChunks; c++) result.Merge(partials[c]);
+		partials.clear();
+
+		// key columns: the first record of each group
+		ITableHandle hKeys = TableOperations::Project(hTable, keyCols);
+		if (!hKeys) return ITableHandle();
+		ITableHandle hOut = TableOperations::Filter(hKeys, result.GetFirstRecords());
+		if (!hOut || !hOut->SetRecordBased(false)) return ITableHandle();
+
+		// aggregate columns
+		IFieldDefsHandle hDefs = hOut->GetFieldDefs();
+		for (UInt s=0; s<noSpecs; s++) {
+			String key = specs[s].ResultKey.Len() ? specs[s].ResultKey : GetResultKey(specs[s]);
+			IFieldDefHandle hNoDef;
+			IFieldDefHandle hDef = hDefs->AddNew(key, hNoDef);
+			if (!hDef || !hDef->SetDataType(aggTypes[s])) return ITableHandle();
+			if (!hOut->GetColumn(key)->SetValues(result.GetResults(s, specs[s].Function, ColumnData::GetStorageType(aggTypes[s])))) return ITableHandle();
+		}
+		if (!hOut->SetRecordBased(true)) return ITableHandle();
+		return hOut;
+	}
+	static ITableHandle GroupBy(ITableHandle &hTable, const StringVector &keyCols, const std::vector<AggregateSpec> &specs) {
+		return GroupBy(hTable, keyCols, specs.empty() ? 0 : &specs[0], (UInt)specs.size());
+	}
+
+private:
+	enum { GrainSize = 64 * 1024 }; // minimum number of records per thread
+
+	typedef KeyTable::Column Column;
+
+	static Double GetValue(const Column &column, size_t i) {
+		switch (column.Type) {
+			case DT_BYTE:   return ColumnData::ToDouble(((const Byte *)column.Ptr)[i]);
+			case DT_INT:    return ColumnData::ToDouble(((const Int *)column.Ptr)[i]);
+			case DT_DOUBLE: return ((const Double *)column.Ptr)[i];
+			default:        return ColumnType<Double>::GetMissing();
+		}
+	}
+
+	static String GetResultKey(const AggregateSpec &spec) {
+		static const char *names[] = { "", "Count", "Sum", "Mean", "Min", "Max", "First", "Last" };
+		if (spec.Function == AF_COUNT) return names[AF_COUNT];
+		return String(names[spec.Function]) + "(" + spec.ColumnKey + ")";
+	}
+
+	// {internal}
+	// Description:
+	// Accumulated aggregate of the values of one group.
+	struct Accumulator {
+		UInt   Count; // number of non-missing values (or records for AF_COUNT)
+		Double Sum, Min, Max, First, Last;
+
+		Accumulator() : Count(0), Sum(0.0), Min(0.0), Max(0.0), First(0.0), Last(0.0) {}
+
+		void Add(Double d) {
+			if (!Count) Min = Max = First = d;
+			else if (d < Min) Min = d;
+			else if (d > Max) Max = d;
+			Sum += d;
+			Last = d;
+			Count++;
+		}
+
+		// merges the accumulator of a later range of records
+		void Merge(const Accumulator &a) {
+			if (!a.Count) return;
+			if (!Count) {
+				*this = a;
+				return;
+			}
+			if (a.Min < Min) Min = a.Min;
+			if (a.Max > Max) Max = a.Max;
+			Sum   += a.Sum;
+			Last   = a.Last;
+			Count += a.Count;
+		}
+	};
+
+	// {internal}
+	// Description:
+	// Groups of records with their composite keys and accumulators.
+	class Groups {
+	public:
+		Groups(size_t noKeys, size_t noSpecs) : m_NoKeys(noKeys), m_NoSpecs(noSpecs), m_Keys(noKeys) {}
+
+		size_t GetCount() const {
+			return m_FirstRecs.size();
+		}
+
+		void Aggregate(const std::vector<Column> &keys, const AggregateSpec *specs, const std::vector<Column> &aggs, size_t first, size_t last) {
+			std::vector<long long> key(m_NoKeys);
+			for (size_t r=first; r<last; r++) {
+				KeyTable::GetKey(keys, r, m_NoKeys ? &key[0] : 0);
+				size_t g = FindOrAdd(m_NoKeys ? &key[0] : 0, (Int)r + 1);
+				Accumulator *pAcc = m_NoSpecs ? &m_Accs[g * m_NoSpecs] : 0;
+				for (size_t s=0; s<m_NoSpecs; s++) {
+					if (specs[s].Function == AF_COUNT) {
+						pAcc[s].Count++;
+						continue;
+					}
+					Double d = GetValue(aggs[s], r);
+					if (d == d) pAcc[s].Add(d);
+				}
+			}
+		}
+
+		void Merge(const Groups &groups) {
+			for (size_t i=0; i<groups.GetCount(); i++) {
+				size_t g = FindOrAdd(groups.m_Keys.GetStoredKey(i), groups.m_FirstRecs[i]);
+				for (size_t s=0; s<m_NoSpecs; s++) m_Accs[g * m_NoSpecs + s].Merge(groups.m_Accs[i * m_NoSpecs + s]);
+			}
+		}
+
+		IntVector GetFirstRecords() const {
+			return m_FirstRecs.empty() ? IntVector() : IntVector(&m_FirstRecs[0], m_FirstRecs.size());
+		}
+
+		Vector GetResults(size_t s, AggregateFunction function, DataType dt) const {
+			size_t n = GetCount();
+			std::vector<Double> results(n);
+			for (size_t g=0; g<n; g++) {
+				const Accumulator &a = m_Accs[g * m_NoSpecs + s];
+				Double d = ColumnType<Double>::GetMissing();
+				switch (function) {
+					case AF_COUNT: d = a.Count; break;
+					case AF_SUM:   d = a.Sum;   break;
+					case AF_MEAN:  if (a.Count) d = a.Sum / a.Count; break;
+					case AF_MIN:   if (a.Count) d = a.Min;   break;
+					case AF_MAX:   if (a.Count) d = a.Max;   break;
+					case AF_FIRST: if (a.Count) d = a.First; break;
+					case AF_LAST:  if (a.Count) d = a.Last;  break;
+				}
+				results[g] = d;
+			}
+			switch (dt) {
+				case DT_BYTE: return Convert<Byte>(results);
+				case DT_INT:  return Convert<Int>(results);
+				default:      return n ? DoubleVector(&results[0], n) : DoubleVector();
+			}
+		}
+
+	private:
+		template<class T> static Vector Convert(const std::vector<Double> &results) {
+			typename ColumnType<T>::VectorType v;
+			T *p = ColumnData::Alloc<T>(v, results.size());
+			for (size_t i=0; i<results.size(); i++) p[i] = ColumnData::IsMissing(results[i]) ? ColumnType<T>::GetMissing() : (T)results[i];
+			return v;
+		}
+
+		// returns the index of the group with the specified key; a new group is added if necessary
+		size_t FindOrAdd(const long long *key, Int firstRec) {
+			size_t g = m_Keys.FindOrAdd(key);
+			if (g == m_FirstRecs.size()) {
+				m_FirstRecs.push_back(firstRec);
+				m_Accs.resize(m_Accs.size() + m_NoSpecs);
+			}
+			return g;
+		}
+
+		size_t                   m_NoKeys;
+		size_t                   m_NoSpecs;
+		KeyTable                 m_Keys;      // composite key per group
+		std::vector<Int>         m_FirstRecs; // first record (1-based) per group
+		std::vector<Accumulator> m_Accs;      // m_NoSpecs accumulators per group
+	};
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_TABLEAGGREGATION_H_INCLUDED */
@@ -0,0 +1,264 @@
+#ifndef DCI_TABLEFILE_H_INCLUDED
+#define DCI_TABLEFILE_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/Error.h"
+#include "DCI/BinaryBuffer.h"
+#include "DCI/BlockCompression.h"
+#include "DCI/BufferedWriter.h"
+#include "DCI/ColumnData.h"
+#include "DCI/EncodedVector.h"
+#include "DCI/Manager.h"
+#include "DCI/MappedTable.h"
+#include "DCI/TableOperations.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Global Modules}
+// Description: Table File Module.
+//
+// Routines saving and loading tables to/from columnar table files
+// (version 2 of the binary table format). Unlike the files written by
+// Manager::SaveTableToBinaryFile (version 1), which are read element by
+// element, a columnar table file starts with a directory of the offsets
+// and sizes of the columns, and the values of every column are stored
+// contiguously at an aligned offset. Thus, single columns can be loaded
+// without parsing the whole file (see LoadTableFromBinaryFile), and
+// plain fixed-width columns can be used in place after mapping the
+// file into memory (see MappedTable).
+class TableFile {
+public:
+	// Description:
+	// Saves a table to a columnar table file.
+	//
+	// Arguments:
+	// hTable          - The handle of the table to be saved.
+	// FileName        - The name of the file.
+	// encodeColumns   - If true, every column is stored sparse, delta or
+	//                   run-length encoded if this is smaller than the
+	//                   plain values (see EncodedVector::ChooseEncoding).
+	//                   Encoded columns are decoded when accessed, so
+	//                   they cannot be used in place.
+	// compressColumns - If true, the payload of every column is block
+	//                   compressed with the codec that suits it best
+	//                   (see BlockCompression::ChooseCodec), unless this
+	//                   does not make it smaller. Compressed columns are
+	//                   decompressed (in parallel) when accessed.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise. In order to
+	// get extended error information, please make use of the Error
+	// module.
+	static Bool Save(ITableHandle &hTable, const String &FileName, Bool encodeColumns = false, Bool compressColumns = false) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = hCols->GetCount();
+		TableFileSchema schema;
+		schema.Assign(hTable);
+		std::vector<Vector> values(noCols);
+		std::vector<TableFileColumn> columns(noCols);
+		std::vector<std::vector<char> > payloads(noCols); // payloads of encoded or compressed columns
+		UInt noRecs = noCols ? hCols->Item(1)->GetLength() : 0;
+		for (UInt c=0; c<noCols; c++) {
+			values[c] = hCols->Item(c+1)->GetValues();
+			columns[c].DataType = ColumnData::GetStorageType(schema.Fields[c].Type);
+			columns[c].Encoding = VE_PLAIN;
+			if (values[c].Len() != noRecs || (noRecs && values[c].GetDataType() != columns[c].DataType) ||
+				(!ColumnData::IsFixedWidth((DataType)columns[c].DataType) && columns[c].DataType != DT_STRING)) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "Columns of this data type are not supported: " + schema.Fields[c].Key);
+				return false;
+			}
+			if (encodeColumns) {
+				EncodedVector ev(values[c], schema.Fields[c].DefaultValue);
+				if (ev.GetEncoding() != VE_PLAIN) {
+					BinaryWriter w(payloads[c]);
+					ev.SaveToBuffer(w);
+					columns[c].Encoding = ev.GetEncoding();
+				}
+			}
+			if (compressColumns) CompressPayload(values[c], noRecs, columns[c], payloads[c]);
+		}
+
+		// layout: header, column directory, schema block, aligned payloads
+		std::vector<char> schemaBlock;
+		schema.Write(schemaBlock);
+		TableFileHeader header;
+		memcpy(header.Magic, "DCITABLE", sizeof(header.Magic));
+		header.Version      = TableFileVersion;
+		header.NoColumns    = noCols;
+		header.NoRecords    = noRecs;
+		header.SchemaOffset = sizeof(header) + noCols * sizeof(TableFileColumn);
+		header.SchemaSize   = schemaBlock.size();
+		unsigned long long offset = header.SchemaOffset + header.SchemaSize;
+		for (UInt c=0; c<noCols; c++) {
+			offset = Align(offset);
+			columns[c].Offset = offset;
+			columns[c].Size   = IsStreamed(columns[c]) ? GetPayloadSize(values[c], (DataType)columns[c].DataType, noRecs) : payloads[c].size();
+			offset += columns[c].Size;
+		}
+
+		FILE *fp = fopen(FileName, "wb");
+		if (!fp) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADPATH, "The file could not be opened: " + FileName);
+			return false;
+		}
+		BufferedWriter w(fp);
+		w.Put(&header, sizeof(header));
+		w.Put(columns.data(), noCols * sizeof(TableFileColumn));
+		w.Put(schemaBlock.data(), schemaBlock.size());
+		offset = header.SchemaOffset + header.SchemaSize;
+		for (UInt c=0; c<noCols; c++) {
+			WritePadding(w, columns[c].Offset - offset);
+			if (IsStreamed(columns[c])) {
+				WritePayload(w, values[c], (DataType)columns[c].DataType, noRecs);
+			} else {
+				w.Put(payloads[c].data(), payloads[c].size());
+			}
+			offset = columns[c].Offset + columns[c].Size;
+		}
+		Bool ok = w.Flush();
+		if (fclose(fp) || !ok) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_ERROR, "The file could not be written: " + FileName);
+			return false;
+		}
+		return true;
+	}
+
+	// Description:
+	// Loads a table from a binary file, optionally restricted to some of
+	// its columns.
+	//
+	// Columnar table files (see Save) are mapped into memory, and only
+	// the payloads of the requested columns are read, on multiple
+	// threads (see MappedTable::CopyColumns). Files written by
+	// Manager::SaveTableToBinaryFile are still supported; they are
+	// loaded completely, and the requested columns are taken from the
+	// loaded table (see TableOperations::Project).
+	//
+	// Arguments:
+	// FileName   - The name of the file.
+	// columnKeys - The keys of the columns to be loaded, in the order of
+	//              the new table's columns. If empty, all columns are
+	//              loaded.
+	//
+	// Returns:
+	// The (record-based) table, or an empty handle in case of an error
+	// (e.g. if there's no column with one of the specified keys). In
+	// order to get extended error information, please make use of the
+	// Error module.
+	static ITableHandle LoadTableFromBinaryFile(const String &FileName, const StringVector &columnKeys = StringVector()) {
+		if (!IsTableFile(FileName)) {
+			ITableHandle hTable = Manager::LoadTableFromBinaryFile(FileName);
+			if (!hTable || !columnKeys.Len()) return hTable;
+			return TableOperations::Project(hTable, columnKeys);
+		}
+		MappedTable table;
+		if (!table.Open(FileName)) {
+			Error::SetError(IUnknownHandle(), EN_ERROR, "The file is not a valid table file: " + FileName);
+			return ITableHandle();
+		}
+		std::vector<UInt> colIdxs(columnKeys.Len() ? columnKeys.Len() : table.GetColumnCount());
+		for (UInt c=0; c<colIdxs.size(); c++) {
+			colIdxs[c] = columnKeys.Len() ? table.IndexOf(columnKeys[c]) : c + 1;
+			if (!colIdxs[c]) {
+				Error::SetError(IUnknownHandle(), EN_BADARG, "There's no column with the specified key: " + columnKeys[c]);
+				return ITableHandle();
+			}
+		}
+		ITableHandle hTable = table.CopyColumns(colIdxs);
+		if (!hTable) Error::SetError(IUnknownHandle(), EN_ERROR, "The table could not be loaded: " + FileName);
+		return hTable;
+	}
+
+	// Description:
+	// Tests if a file is a columnar table file (see Save), as opposed to
+	// a file written by Manager::SaveTableToBinaryFile.
+	//
+	// Arguments:
+	// FileName - The name of the file.
+	static Bool IsTableFile(const String &FileName) {
+		TableFileHeader header;
+		FILE *fp = fopen(FileName, "rb");
+		if (!fp) return false;
+		Bool isTableFile = fread(header.Magic, sizeof(header.Magic), 1, fp) == 1 && !memcmp(header.Magic, "DCITABLE", sizeof(header.Magic));
+		fclose(fp);
+		return isTableFile;
+	}
+
+private:
+	// tests if the payload of a column is written from its values directly, rather than from a buffer
+	static Bool IsStreamed(const TableFileColumn &column) {
+		return column.Encoding == VE_PLAIN && column.Codec == CC_NONE;
+	}
+
+	// compresses the payload of a column, if this makes it smaller
+	static void CompressPayload(const Vector &v, UInt noRecs, TableFileColumn &column, std::vector<char> &payload) {
+		std::vector<char> strings;
+		const char *p;
+		size_t size;
+		if (column.Encoding != VE_PLAIN) {
+			p    = payload.data();
+			size = payload.size();
+		} else if (column.DataType == DT_STRING) {
+			BinaryWriter w(strings);
+			WriteStrings(w, v, noRecs);
+			p    = strings.data();
+			size = strings.size();
+		} else {
+			p    = (const char *)ColumnData::GetDataPtr(v);
+			size = (size_t)noRecs * column.GetFilterWidth();
+		}
+		CompressionCodec codec = BlockCompression::ChooseCodec(p, size, column.GetFilterWidth());
+		if (codec == CC_NONE) return;
+		std::vector<char> compressed;
+		BlockCompression::Compress(p, size, column.GetFilterWidth(), codec, compressed);
+		if (compressed.size() >= size) return;
+		payload.swap(compressed);
+		column.Codec = codec;
+	}
+
+	static unsigned long long Align(unsigned long long offset) {
+		return (offset + TableFileAlignment - 1) / TableFileAlignment * TableFileAlignment;
+	}
+
+	static unsigned long long GetPayloadSize(const Vector &v, DataType dt, UInt noRecs) {
+		if (dt != DT_STRING) return (unsigned long long)noRecs * ColumnData::GetElementSize(dt);
+		unsigned long long size = (noRecs + 1ULL) * sizeof(unsigned long long);
+		const String *p = noRecs ? StringVector(v).GetPtr() : 0;
+		for (UInt i=0; i<noRecs; i++) size += p[i].Len() + 1;
+		return size;
+	}
+
+	static void WritePadding(BufferedWriter &w, unsigned long long size) {
+		static const char zeros[TableFileAlignment] = { 0 };
+		w.Put(zeros, (size_t)size);
+	}
+
+	// writes the payload of a plain column; the values of a fixed-width column are written in one piece
+	static void WritePayload(BufferedWriter &w, const Vector &v, DataType dt, UInt noRecs) {
+		if (dt == DT_STRING) {
+			WriteStrings(w, noRecs ? StringVector(v) : StringVector(), noRecs);
+		} else if (noRecs) {
+			w.Put(ColumnData::GetDataPtr(v), noRecs * ColumnData::GetElementSize(dt));
+		}
+	}
+
+	// writes the offsets of the strings, followed by the zero-terminated strings
+	template<class W> static void WriteStrings(W &w, const StringVector &sv, UInt noRecs) {
+		const String *p = noRecs ? sv.GetPtr() : 0;
+		unsigned long long offset = 0;
+		for (UInt i=0; i<=noRecs; i++) {
+			w.Put(&offset, sizeof(offset));
+			if (i < noRecs) offset += p[i].Len() + 1;
+		}
+		for (UInt i=0; i<noRecs; i++) w.Put((const char *)p[i], p[i].Len() + 1);
+	}
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_TABLEFILE_H_INCLUDED */
@@ -0,0 +1,1032 @@
+#ifndef DCI_TABLEOPERATIONS_H_INCLUDED
+#define DCI_TABLEOPERATIONS_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/Error.h"
+#include "DCI/ColumnData.h"
+#include "DCI/KeyTable.h"
+#include "DCI/Manager.h"
+#include "DCI/Parallel.h"
+#include "DCI/RecordCursor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Enumeration Types}
+// Description: Join Types.
+enum JoinType {
+	JT_INNER = 1, // Only records with matching keys in both tables.
+	JT_LEFT  = 2  // All records of the left table, matched or not.
+};
+
+// {group:Global Modules}
+// Description: Table Operations Module.
+//
+// The table operations module provides bulk operations on tables
+// working on entire column vectors instead of individual fields.
+class TableOperations {
+public:
+	// Description:
+	// Appends records (rows) to a table in one operation.
+	//
+	// The new values are provided as one vector per column; all
+	// vectors must have the same length and the data type of the
+	// values stored in the respective column. All arguments are
+	// validated before the table is modified. Every call copies the
+	// existing values of each column into a new vector, which is
+	// assigned with a single SetValues call; the library then validates
+	// all values of the column again. The cost of a call is thus
+	// proportional to the number of records of the table rather than to
+	// the number of records appended, so records arriving in many small
+	// batches should be buffered (e.g. in one ChunkedVector per column)
+	// and appended in a single call. If the table is record-based, it
+	// is switched to column-based meanwhile, so that the columns are
+	// not redimensioned. If a column rejects its new values, the
+	// columns are restored to their original values.
+	//
+	// Arguments:
+	// hTable    - The handle of the table to be appended to.
+	// newValues - Array of vectors containing the values to be
+	//             appended, one vector per column in column order.
+	// noCols    - Number of vectors in newValues. Must be equal to
+	//             the number of columns of the table.
+	// block     - Column-major block of double values to be appended
+	//             (noRecs values of the first column, followed by
+	//             noRecs values of the second column, ...). The values
+	//             are converted to the data type of the respective
+	//             column; NaN is converted to the missing value of
+	//             byte and integer columns. The values of byte and
+	//             integer columns must be NaN or integral and within
+	//             the range of the data type (see BYTE_MIN, BYTE_MAX).
+	//             All columns must have a numeric data type.
+	// noRecs    - Number of records contained in the block.
+	//
+	// Returns:
+	// true if the records were appended, or false otherwise.
+	// In order to get extended error information, please make
+	// use of the Error module.
+	static Bool AppendRecords(ITableHandle &hTable, const Vector *newValues, UInt noCols) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		if (noCols != hCols->GetCount()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The number of vectors does not match the number of columns.");
+			return false;
+		}
+		if (!noCols) return true;
+
+		// validation pass: lengths and data types
+		size_t noNewRecs = newValues[0].Len();
+		std::vector<IVariableHandle> columns(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			columns[i] = hCols->Item(i+1);
+			if (newValues[i].Len() != noNewRecs) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "All vectors must have the same length.");
+				return false;
+			}
+			DataType dt = ColumnData::GetStorageType(columns[i]->GetFieldDef()->GetDataType());
+			if (noNewRecs && newValues[i].GetDataType() != dt) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The data type of a vector does not match the data type of its column.");
+				return false;
+			}
+		}
+		if (!noNewRecs) return true;
+
+		// one concatenation per column, before the table is modified
+		Bool recBsd = hTable->GetRecordBased();
+		UInt noRecs = recBsd ? columns[0]->GetLength() : 0;
+		std::vector<Vector> heads(noCols), results(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			heads[i] = columns[i]->GetValues();
+			if (!Concat(heads[i], recBsd ? noRecs : heads[i].Len(), newValues[i], results[i])) return false;
+		}
+		return ReplaceColumns(hTable, heads, results);
+	}
+	static Bool AppendRecords(ITableHandle &hTable, const Double *block, UInt noRecs) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = hCols->GetCount();
+		std::vector<Vector> newValues(noCols);
+		for (UInt i=0; i<noCols; i++) {
+			const Double *pSrc = block + (size_t)i * noRecs;
+			Bool isValid = true;
+			switch (ColumnData::GetStorageType(hCols->Item(i+1)->GetFieldDef()->GetDataType())) {
+				case DT_BYTE:   isValid = FromDoubles<Byte>(pSrc, noRecs, newValues[i]); break;
+				case DT_INT:    isValid = FromDoubles<Int>(pSrc, noRecs, newValues[i]);  break;
+				case DT_DOUBLE: newValues[i] = DoubleVector(pSrc, noRecs);               break;
+				default:
+					Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "All columns must have a numeric data type.");
+					return false;
+			}
+			if (!isValid) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "A value cannot be converted to the data type of its column.");
+				return false;
+			}
+		}
+		return AppendRecords(hTable, noCols ? &newValues[0] : 0, noCols);
+	}
+
+	// Description:
+	// Exports a record-based table with numeric columns to a dense
+	// matrix of double precision floating point values.
+	//
+	// Byte, integer and date/time values are converted to doubles;
+	// missing values are exported as NaN. Columns are read directly
+	// from their value vectors. A row-major export transposes the
+	// columns block-wise (a block of records at a time) on multiple
+	// threads.
+	//
+	// Arguments:
+	// hTable   - The handle of the table to be exported.
+	// matrix   - The matrix receiving the values. Must provide space
+	//            for (number of records * number of columns) values.
+	//            If a DoubleVector is supplied, it is redimensioned
+	//            after the table has been validated.
+	// rowMajor - true for row-major layout (the values of a record are
+	//            adjacent), false for column-major layout (the values
+	//            of a column are adjacent, as used by Matlab and R).
+	//
+	// Returns:
+	// true if the table was exported, or false otherwise (e.g. if
+	// the table is not record-based or a column is not numeric).
+	// In order to get extended error information, please make
+	// use of the Error module.
+	static Bool ExportToDenseMatrix(ITableHandle &hTable, Double *matrix, Bool rowMajor = false) {
+		std::vector<Vector> values;
+		std::vector<DenseColumn> columns;
+		UInt noRecs;
+		if (!GetDenseColumns(hTable, values, columns, noRecs)) return false;
+		ExportColumns(columns, noRecs, matrix, rowMajor);
+		return true;
+	}
+	static Bool ExportToDenseMatrix(ITableHandle &hTable, DoubleVector &matrix, Bool rowMajor = false) {
+		std::vector<Vector> values;
+		std::vector<DenseColumn> columns;
+		UInt noRecs;
+		if (!GetDenseColumns(hTable, values, columns, noRecs)) return false;
+		size_t Len = (size_t)noRecs * columns.size();
+		Double *p = ColumnData::Alloc<Double>(matrix, Len);
+		if (!Len) return true;
+		if (!p) return false;
+		ExportColumns(columns, noRecs, p, rowMajor);
+		return true;
+	}
+
+	// Description:
+	// Imports the data of a table with numeric columns from a dense 
+	// matrix of double precision floating point values.
+	//
+	// The table must already have the desired columns; the number of
+	// columns of the matrix must match the number of columns of the
+	// table. The values are converted to the data types of the columns;
+	// NaN is converted to the missing value of byte and integer columns.
+	// The values of byte and integer columns must be NaN or integral and
+	// within the range of the data type; all values are converted and
+	// checked before the table is modified. Each column is written with
+	// a single SetValues call; a record-based table is switched to
+	// column-based meanwhile, so that it is not redimensioned. If a
+	// column rejects its new values, the columns are restored to their
+	// original values.
+	//
+	// Arguments:
+	// hTable   - The handle of the table to be imported to.
+	// matrix   - The matrix holding (noRecs * number of columns) values.
+	// noRecs   - The number of records (rows) of the matrix.
+	// rowMajor - true for row-major layout, false for column-major
+	//            layout (see ExportToDenseMatrix).
+	//
+	// Returns:
+	// true if the table was imported, or false otherwise.
+	// In order to get extended error information, please make
+	// use of the Error module.
+	static Bool ImportFromDenseMatrix(ITableHandle &hTable, const Double *matrix, UInt noRecs, Bool rowMajor = false) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		size_t noCols = hCols->GetCount();
+		std::vector<Vector>      newValues(noCols);
+		std::vector<DenseColumn> columns(noCols);
+		for (size_t c=0; c<noCols; c++) {
+			columns[c].Type = ColumnData::GetStorageType(hCols->Item((UInt)c+1)->GetFieldDef()->GetDataType());
+			switch (columns[c].Type) {
+				case DT_BYTE:   columns[c].Ptr = AllocColumn<Byte>(newValues[c], noRecs);   break;
+				case DT_INT:    columns[c].Ptr = AllocColumn<Int>(newValues[c], noRecs);    break;
+				case DT_DOUBLE: columns[c].Ptr = AllocColumn<Double>(newValues[c], noRecs); break;
+				default:
+					Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "All columns must have a numeric data type.");
+					return false;
+			}
+			if (noRecs && !columns[c].Ptr) return false;
+		}
+		std::atomic<bool> isValid(true);
+		if (!rowMajor) {
+			Parallel::For(0, noCols, 1, [&](size_t c0, size_t c1) {
+				for (size_t c=c0; c<c1; c++) {
+					if (!FromDoubles(matrix + c * noRecs, 1, columns[c], 0, noRecs)) isValid = false;
+				}
+			});
+		} else {
+			size_t tileRecs = GetTileRecordCount(noCols);
+			Parallel::For(0, noRecs, tileRecs, [&](size_t r0, size_t r1) {
+				for (size_t rt=r0; rt<r1; rt+=tileRecs) {
+					size_t re = (r1 - rt < tileRecs) ? r1 : rt + tileRecs;
+					for (size_t c=0; c<noCols; c++) {
+						if (!FromDoubles(matrix + rt * noCols + c, noCols, columns[c], rt, re)) isValid = false;
+					}
+				}
+			});
+		}
+		if (!isValid) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "A value cannot be converted to the data type of its column.");
+			return false;
+		}
+		std::vector<Vector> oldValues(noCols);
+		for (size_t c=0; c<noCols; c++) oldValues[c] = hCols->Item((UInt)c+1)->GetValues();
+		return ReplaceColumns(hTable, oldValues, newValues);
+	}
+
+	// Description:
+	// Creates a copy of a table whose columns share their value
+	// vectors with the source table (copy-on-write).
+	//
+	// Unlike ITable::AssignFrom, which copies all values, only the
+	// schema (field definitions and attributes) is copied; every column
+	// of the clone references the representation of the respective
+	// source column (see VectorRepBase), so no values are copied. A
+	// column's values are copied only when either table modifies them.
+	// Assigning the shared vectors to the new columns still makes the
+	// library validate every value, so the cost of a clone is
+	// proportional to the number of values, though without the
+	// allocations and copies of AssignFrom.
+	//
+	// Please note, that the reference counting of vectors is not
+	// synchronized, and even reading the values of a column (e.g. by
+	// IVariable::GetValues) copies a vector handle. Tables sharing
+	// vectors must therefore not be used on different threads at the
+	// same time, not even for reading. Tables meant for other threads
+	// should be independent copies (see ITable::AssignFrom) created on
+	// the calling thread.
+	//
+	// Arguments:
+	// hTable - The handle of the table to be cloned.
+	//
+	// Returns:
+	// The new table, or an empty handle in case of an error. In order
+	// to get extended error information, please make use of the Error
+	// module.
+	static ITableHandle Clone(ITableHandle &hTable) {
+		Bool recBsd = hTable->GetRecordBased();
+		ITableHandle hNew = Manager::CreateTable();
+		if (!hNew || !hNew->AssignSchemaFrom(hTable) || !hNew->SetRecordBased(false)) return ITableHandle();
+		IVariablesHandle hCols = hTable->GetColumns();
+		std::vector<Vector> values(hCols->GetCount());
+		for (UInt c=0; c<values.size(); c++) values[c] = hCols->Item(c+1)->GetValues();
+		if (!SetColumns(hNew, values, recBsd)) return ITableHandle();
+		return hNew;
+	}
+
+	// Description:
+	// Creates a new table containing a subset of the columns of a
+	// table (relational projection).
+	//
+	// The field definitions of the selected columns are copied to the
+	// new table. The new columns share their value vectors with the
+	// source columns (see VectorRepBase), so no values are copied until
+	// either table modifies them.
+	//
+	// Arguments:
+	// hTable  - The handle of the source table.
+	// colKeys - The keys of the columns to be included, in the order
+	//           of the new table's columns.
+	//
+	// Returns:
+	// The new table, or an empty handle in case of an error (e.g. if
+	// there's no column with one of the specified keys). In order to
+	// get extended error information, please make use of the Error
+	// module.
+	static ITableHandle Project(ITableHandle &hTable, const StringVector &colKeys) {
+		Bool recBsd = hTable->GetRecordBased();
+		ITableHandle hNew = Manager::CreateTable();
+		if (!hNew || !hNew->SetRecordBased(false)) return ITableHandle();
+		hNew->SetName(hTable->GetName());
+		hNew->SetDescription(hTable->GetDescription());
+		IFieldDefsHandle hNewDefs = hNew->GetFieldDefs();
+		std::vector<Vector> values(colKeys.Len());
+		for (size_t i=0; i<colKeys.Len(); i++) {
+			IFieldDefHandle hDef = hTable->GetFieldDef(colKeys[i]);
+			if (!hDef) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "There's no column with the specified key: " + colKeys[i]);
+				return ITableHandle();
+			}
+			if (!hNewDefs->AddNew(colKeys[i], hDef)) return ITableHandle();
+			values[i] = hTable->GetColumn(colKeys[i])->GetValues();
+		}
+		if (!SetColumns(hNew, values, recBsd)) return ITableHandle();
+		return hNew;
+	}
+
+	// Description:
+	// Creates a new table containing a subset of the records of a
+	// table (relational selection).
+	//
+	// The schema of the source table is copied to the new table. Every
+	// column of the new table is built with a single gather over the
+	// source column's value vector. The records can be specified by
+	// their indexes (e.g. as returned by Where or
+	// TableIndexes::FindRecords) or by a predicate.
+	//
+	// Arguments:
+	// hTable    - The handle of the source table.
+	// recIdxs   - The indexes of the records to be included, in the
+	//             order of the new table's records. The index of the
+	//             first record is 1. Indexes may be repeated.
+	// predicate - Function object called as predicate(rec) for every
+	//             record of the table, rec being a const RecordCursor
+	//             positioned at the record. The record is included if
+	//             the predicate returns true.
+	//
+	// Returns:
+	// The new table, or an empty handle in case of an error (e.g. if
+	// a record index is out of range). In order to get extended error
+	// information, please make use of the Error module.
+	static ITableHandle Filter(ITableHandle &hTable, const IntVector &recIdxs) {
+		Bool recBsd = hTable->GetRecordBased();
+		ITableHandle hNew = Manager::CreateTable();
+		if (!hNew || !hNew->AssignSchemaFrom(hTable) || !hNew->SetRecordBased(false)) return ITableHandle();
+		IVariablesHandle hCols = hTable->GetColumns();
+		size_t n = recIdxs.Len();
+		const Int *pIdx = n ? recIdxs.GetPtr() : 0;
+		std::vector<Vector> values(hCols->GetCount());
+		for (UInt c=0; c<values.size(); c++) {
+			if (!Gather(hCols->Item(c+1)->GetValues(), pIdx, n, values[c])) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "A record index is out of range.");
+				return ITableHandle();
+			}
+		}
+		if (!SetColumns(hNew, values, recBsd)) return ITableHandle();
+		return hNew;
+	}
+	template<class P> static ITableHandle Filter(ITableHandle &hTable, P predicate) {
+		std::vector<Int> recIdxs;
+		for (RecordCursor rec(hTable); !rec.IsEOF(); rec.MoveNext()) {
+			if (predicate((const RecordCursor &)rec)) recIdxs.push_back((Int)rec.GetIndex());
+		}
+		return Filter(hTable, recIdxs.empty() ? IntVector() : IntVector(&recIdxs[0], recIdxs.size()));
+	}
+
+	// Description:
+	// Returns the records of a table satisfying a predicate on the
+	// values of a single numeric column.
+	//
+	// The column's value vector is scanned directly; the predicate is
+	// called with the raw values, i.e. missing values are passed as
+	// BYTE_NAN, INT_NAN or NaN, respectively.
+	//
+	// Arguments:
+	// T         - The storage data type of the column (Byte, Int or
+	//             Double; see ColumnData::GetStorageType).
+	// hTable    - The handle of the table.
+	// colKey    - Key associated with the column.
+	// predicate - Function object called as predicate(value) for every
+	//             value of the column.
+	//
+	// Returns:
+	// The indexes of the records for which the predicate returns true,
+	// in ascending order. The index of the first record is 1. In case
+	// of an error (e.g. if the column's data type does not match T),
+	// an empty vector is returned; in order to get extended error
+	// information, please make use of the Error module.
+	template<class T, class P> static IntVector Where(ITableHandle &hTable, const String &colKey, P predicate) {
+		IVariableHandle hCol = hTable->GetColumn(colKey);
+		if (!hCol) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "There's no column with the specified key: " + colKey);
+			return IntVector();
+		}
+		Vector values = hCol->GetValues();
+		if (values.Len() && values.GetDataType() != ColumnType<T>::GetDataType()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The data type of the column does not match.");
+			return IntVector();
+		}
+		const T *p = ColumnData::GetPtr<T>(values);
+		std::vector<Int> recIdxs;
+		for (size_t i=0; i<values.Len(); i++) {
+			if (predicate(p[i])) recIdxs.push_back((Int)i + 1);
+		}
+		return recIdxs.empty() ? IntVector() : IntVector(&recIdxs[0], recIdxs.size());
+	}
+
+	// Description:
+	// Sorts the records of a record-based table by the values of one
+	// or more key columns.
+	//
+	// A single permutation of the records is computed first: byte,
+	// integer and double (date/time) keys are sorted by an LSD radix
+	// sort, string keys by a stable comparison sort. Multiple keys are
+	// handled by stable passes from the last key to the first. The
+	// permutation is then applied to every column in one pass, the
+	// columns being processed in parallel. Missing values are sorted
+	// last; records with equal keys keep their order. If a column
+	// rejects its sorted values, the columns are restored to their
+	// original order.
+	//
+	// Arguments:
+	// hTable    - The handle of the table to be sorted.
+	// colKeys   - The keys of the columns to be sorted by, most
+	//             significant first.
+	// ascending - Array holding one flag per key column: true for
+	//             ascending and false for descending order. If NULL,
+	//             all keys are sorted in ascending order.
+	//
+	// Returns:
+	// true if the table was sorted, or false otherwise (e.g. if a key
+	// column contains variant values). In order to get extended error
+	// information, please make use of the Error module.
+	static Bool SortRecords(ITableHandle &hTable, const StringVector &colKeys, const Bool *ascending = 0) {
+		if (!hTable->GetRecordBased()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The table must be record-based.");
+			return false;
+		}
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = hCols->GetCount();
+		size_t noRecs = noCols ? hCols->Item(1)->GetLength() : 0;
+
+		// the permutation, refined by stable passes from the last key to the first
+		std::vector<UInt> perm(noRecs);
+		for (size_t i=0; i<noRecs; i++) perm[i] = (UInt)i;
+		for (size_t k=colKeys.Len(); k-- > 0; ) {
+			IVariableHandle hCol = hTable->GetColumn(colKeys[k]);
+			if (!hCol) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "There's no column with the specified key: " + colKeys[k]);
+				return false;
+			}
+			Vector v = hCol->GetValues();
+			Bool asc = !ascending || ascending[k];
+			switch (noRecs ? v.GetDataType() : DT_VOID) {
+				case DT_VOID:   break;
+				case DT_BYTE:   RadixSort(ColumnData::GetPtr<Byte>(v), asc, 2, perm);   break;
+				case DT_INT:    RadixSort(ColumnData::GetPtr<Int>(v), asc, 5, perm);    break;
+				case DT_DOUBLE: RadixSort(ColumnData::GetPtr<Double>(v), asc, 8, perm); break;
+				case DT_STRING: SortStrings(StringVector(v), asc, perm);                 break;
+				default:
+					Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "Columns of this data type cannot be sorted: " + colKeys[k]);
+					return false;
+			}
+		}
+		if (noRecs < 2 || !colKeys.Len()) return true;
+
+		// apply the permutation; fixed-width columns are permuted in parallel
+		std::vector<Int> recIdxs(noRecs);
+		for (size_t i=0; i<noRecs; i++) recIdxs[i] = (Int)perm[i] + 1;
+		std::vector<Vector> values(noCols), sorted(noCols);
+		std::vector<DenseColumn> src(noCols), dst(noCols);
+		for (UInt c=0; c<noCols; c++) {
+			values[c] = hCols->Item(c+1)->GetValues();
+			src[c].Type = dst[c].Type = values[c].GetDataType();
+			switch (src[c].Type) {
+				case DT_BYTE:   src[c].Ptr = (void *)ColumnData::GetPtr<Byte>(values[c]);   dst[c].Ptr = AllocColumn<Byte>(sorted[c], noRecs);   break;
+				case DT_INT:    src[c].Ptr = (void *)ColumnData::GetPtr<Int>(values[c]);    dst[c].Ptr = AllocColumn<Int>(sorted[c], noRecs);    break;
+				case DT_DOUBLE: src[c].Ptr = (void *)ColumnData::GetPtr<Double>(values[c]); dst[c].Ptr = AllocColumn<Double>(sorted[c], noRecs); break;
+				default:
+					// strings and variant values are reference counted, thus not permuted in parallel
+					src[c].Ptr = dst[c].Ptr = 0;
+					if (!Gather(values[c], &recIdxs[0], noRecs, sorted[c])) return false;
+					break;
+			}
+			if (src[c].Ptr && (!dst[c].Ptr || values[c].Len() != noRecs)) return false;
+		}
+		Parallel::For(0, noCols, 1, [&](size_t c0, size_t c1) {
+			for (size_t c=c0; c<c1; c++) Permute(src[c], dst[c], &perm[0], noRecs);
+		});
+		return ReplaceColumns(hTable, values, sorted);
+	}
+
+	// Description:
+	// Joins two record-based tables on one or more key columns
+	// (hash join).
+	//
+	// A hash table of the keys of the smaller table (the build side) is
+	// built first; the records of the other table (the probe side) are
+	// then looked up in parallel. String keys are dictionary-encoded,
+	// so only integers are hashed. Records with a missing key value
+	// never match.
+	//
+	// The result table has one record per matching pair of records,
+	// ordered by the left record and then by the right record. For a
+	// left join, a left record without any match yields one record
+	// whose right columns are missing (BYTE_NAN, INT_NAN, NaN, empty
+	// strings). The result contains all columns of the left table,
+	// followed by the columns of the right table except its key
+	// columns. A right column whose key is already used gets the
+	// specified suffix appended. Every column is built with a single
+	// gather over its source column.
+	//
+	// Arguments:
+	// hLeft     - The handle of the left table.
+	// hRight    - The handle of the right table.
+	// leftKeys  - The keys of the key columns of the left table.
+	// rightKeys - The keys of the key columns of the right table, in
+	//             the order of leftKeys. Each key column must have the
+	//             same storage data type as the respective left column.
+	// type      - The join type (JT_INNER or JT_LEFT).
+	// suffix    - Suffix of the keys of right columns clashing with
+	//             keys of left columns.
+	//
+	// Returns:
+	// The result table, or an empty handle in case of an error. In
+	// order to get extended error information, please make use of the
+	// Error module.
+	static ITableHandle Join(ITableHandle &hLeft, ITableHandle &hRight, const StringVector &leftKeys, const StringVector &rightKeys, JoinType type = JT_INNER, const String &suffix = "_2") {
+		if (!hLeft->GetRecordBased() || !hRight->GetRecordBased()) {
+			Error::SetError(IUnknownHandle(hLeft.GetPtr()), EN_BADARG, "The tables must be record-based.");
+			return ITableHandle();
+		}
+		size_t noKeys = leftKeys.Len();
+		if (!noKeys || rightKeys.Len() != noKeys) {
+			Error::SetError(IUnknownHandle(hLeft.GetPtr()), EN_BADARG, "The tables must be joined on the same (non-zero) number of key columns.");
+			return ITableHandle();
+		}
+		size_t noLeft  = GetRecordCount(hLeft);
+		size_t noRight = GetRecordCount(hRight);
+		Bool buildLeft = noLeft < noRight;
+
+		// resolve the key columns; strings are encoded with a dictionary of the build side
+		std::vector<Vector> values(2 * noKeys);
+		std::vector<KeyTable::Column> leftCols(noKeys), rightCols(noKeys);
+		for (size_t k=0; k<noKeys; k++) {
+			IVariableHandle hLeftCol = hLeft->GetColumn(leftKeys[k]), hRightCol = hRight->GetColumn(rightKeys[k]);
+			if (!hLeftCol || !hRightCol) {
+				Error::SetError(IUnknownHandle(hLeft.GetPtr()), EN_BADARG, "There's no column with the specified key: " + (hLeftCol ? rightKeys[k] : leftKeys[k]));
+				return ITableHandle();
+			}
+			DataType dt = ColumnData::GetStorageType(hLeftCol->GetFieldDef()->GetDataType());
+			if (dt != ColumnData::GetStorageType(hRightCol->GetFieldDef()->GetDataType())) {
+				Error::SetError(IUnknownHandle(hLeft.GetPtr()), EN_BADARG, "The data types of the key columns do not match: " + leftKeys[k]);
+				return ITableHandle();
+			}
+			Vector &lv = values[2 * k], &rv = values[2 * k + 1];
+			lv = hLeftCol->GetValues();
+			rv = hRightCol->GetValues();
+			if (dt == DT_STRING) {
+				KeyTable::Dictionary dict;
+				Vector lc = KeyTable::Encode(StringVector(buildLeft ? lv : rv), dict, true);
+				Vector rc = KeyTable::Encode(StringVector(buildLeft ? rv : lv), dict, false);
+				lv = buildLeft ? lc : rc;
+				rv = buildLeft ? rc : lc;
+			}
+			if (!KeyTable::GetColumn(lv, leftCols[k]) || !KeyTable::GetColumn(rv, rightCols[k])) {
+				Error::SetError(IUnknownHandle(hLeft.GetPtr()), EN_BADARG, "Key columns of this data type are not supported: " + leftKeys[k]);
+				return ITableHandle();
+			}
+		}
+		const std::vector<KeyTable::Column> &buildCols = buildLeft ? leftCols : rightCols;
+		const std::vector<KeyTable::Column> &probeCols = buildLeft ? rightCols : leftCols;
+		size_t noBuild = buildLeft ? noLeft : noRight;
+		size_t noProbe = buildLeft ? noRight : noLeft;
+
+		// build: the records of each distinct key, in record order (compressed rows)
+		KeyTable keys(noKeys);
+		std::vector<UInt> keyIdxs(noBuild);
+		std::vector<long long> key(noKeys);
+		for (size_t r=0; r<noBuild; r++) {
+			keyIdxs[r] = HasMissingKey(buildCols, r) ? ~0U : (UInt)keys.FindOrAdd(GetKey(buildCols, r, key));
+		}
+		std::vector<UInt> offsets(keys.GetCount() + 1, 0), buildRecs;
+		for (size_t r=0; r<noBuild; r++) if (keyIdxs[r] != ~0U) offsets[keyIdxs[r] + 1]++;
+		for (size_t g=0; g<keys.GetCount(); g++) offsets[g + 1] += offsets[g];
+		buildRecs.resize(offsets.back());
+		std::vector<UInt> next(offsets.begin(), offsets.end() - 1);
+		for (size_t r=0; r<noBuild; r++) if (keyIdxs[r] != ~0U) buildRecs[next[keyIdxs[r]]++] = (UInt)r;
+		keyIdxs.clear();
+		next.clear();
+
+		// probe: matching pairs (probe record, build record) of contiguous ranges of records, one per thread
+		Bool keepUnmatched = type == JT_LEFT && !buildLeft;
+		size_t noChunks = noProbe ? (noProbe + JoinGrainSize - 1) / JoinGrainSize : 0;
+		if (noChunks > Parallel::GetThreadCount()) noChunks = Parallel::GetThreadCount();
+		std::vector<std::vector<Int> > pairs(noChunks);
+		Parallel::For(0, noChunks, 1, [&](size_t c0, size_t c1) {
+			std::vector<long long> probeKey(noKeys);
+			for (size_t c=c0; c<c1; c++) {
+				for (size_t r = noProbe * c / noChunks; r < noProbe * (c + 1) / noChunks; r++) {
+					size_t g = HasMissingKey(probeCols, r) ? keys.GetCount() : keys.Find(GetKey(probeCols, r, probeKey));
+					if (g < keys.GetCount()) {
+						for (UInt i=offsets[g]; i<offsets[g + 1]; i++) {
+							pairs[c].push_back((Int)r + 1);
+							pairs[c].push_back((Int)buildRecs[i] + 1);
+						}
+					} else if (keepUnmatched) {
+						pairs[c].push_back((Int)r + 1);
+						pairs[c].push_back(0);
+					}
+				}
+			}
+		});
+
+		// the record indexes of both tables, ordered by the left record
+		size_t noPairs = 0;
+		for (size_t c=0; c<noChunks; c++) noPairs += pairs[c].size() / 2;
+		std::vector<Int> leftIdxs, rightIdxs;
+		if (!buildLeft) {
+			leftIdxs.reserve(noPairs);
+			rightIdxs.reserve(noPairs);
+			for (size_t c=0; c<noChunks; c++) {
+				for (size_t i=0; i<pairs[c].size(); i+=2) {
+					leftIdxs.push_back(pairs[c][i]);
+					rightIdxs.push_back(pairs[c][i + 1]);
+				}
+			}
+		} else {
+			// the pairs are ordered by the right record: counting sort by the left record (stable)
+			std::vector<size_t> counts(noLeft + 1, 0);
+			for (size_t c=0; c<noChunks; c++) {
+				for (size_t i=0; i<pairs[c].size(); i+=2) counts[pairs[c][i + 1]]++;
+			}
+			if (type == JT_LEFT) {
+				for (size_t l=1; l<=noLeft; l++) {
+					if (!counts[l]) {
+						counts[l] = 1;
+						noPairs++;
+					}
+				}
+			}
+			leftIdxs.assign(noPairs, 0);
+			rightIdxs.assign(noPairs, 0);
+			for (size_t l=1, offset=0; l<=noLeft; l++) {
+				size_t count = counts[l];
+				counts[l] = offset;
+				offset += count;
+				for (size_t i=counts[l]; i<offset; i++) leftIdxs[i] = (Int)l;
+			}
+			for (size_t c=0; c<noChunks; c++) {
+				for (size_t i=0; i<pairs[c].size(); i+=2) rightIdxs[counts[pairs[c][i + 1]]++] = pairs[c][i];
+			}
+		}
+		pairs.clear();
+
+		// left columns: one gather per column, including the schema
+		ITableHandle hOut = Filter(hLeft, leftIdxs.empty() ? IntVector() : IntVector(&leftIdxs[0], leftIdxs.size()));
+		if (!hOut || !hOut->SetRecordBased(false)) return ITableHandle();
+		leftIdxs.clear();
+
+		// right columns except the key columns
+		IVariablesHandle hRightCols = hRight->GetColumns();
+		IFieldDefsHandle hOutDefs = hOut->GetFieldDefs();
+		for (UInt c=1; c<=hRightCols->GetCount(); c++) {
+			String colKey = hRightCols->KeyOf(c);
+			Bool isKey = false;
+			for (size_t k=0; k<noKeys && !isKey; k++) isKey = rightKeys[k] == colKey;
+			if (isKey) continue;
+			while (hOutDefs->Exists(colKey)) colKey += suffix;
+			IFieldDefHandle hDef = hRight->GetFieldDef(c);
+			Vector v;
+			if (!hOutDefs->AddNew(colKey, hDef)) return ITableHandle();
+			if (!Gather(hRightCols->Item(c)->GetValues(), rightIdxs.empty() ? 0 : &rightIdxs[0], rightIdxs.size(), v, true)) return ITableHandle();
+			if (!hOut->GetColumn(colKey)->SetValues(v)) return ITableHandle();
+		}
+		if (!hOut->SetRecordBased(true)) return ITableHandle();
+		return hOut;
+	}
+
+private:
+	// {internal}
+	// Description:
+	// Assigns value vectors to the columns of a new, non-record-based
+	// table and makes the table record-based afterwards, if requested.
+	// Assigning the vectors before enabling the records avoids
+	// redimensioning (and thus copying) the columns.
+	static Bool SetColumns(ITableHandle &hNew, const std::vector<Vector> &values, Bool recBsd) {
+		IVariablesHandle hCols = hNew->GetColumns();
+		for (UInt c=0; c<values.size(); c++) {
+			if (!hCols->Item(c+1)->SetValues(values[c])) return false;
+		}
+		return !recBsd || hNew->SetRecordBased(true);
+	}
+
+	// {internal}
+	// Description:
+	// Assigns new value vectors to all columns of a table. A record-based
+	// table is switched to column-based meanwhile, so that the columns
+	// may differ in length and are not redimensioned. If a column rejects
+	// its new values, the columns are restored to their original values
+	// (oldValues) and false is returned.
+	static Bool ReplaceColumns(ITableHandle &hTable, const std::vector<Vector> &oldValues, const std::vector<Vector> &newValues) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		Bool recBsd = hTable->GetRecordBased();
+		if (recBsd && !hTable->SetRecordBased(false)) return false;
+		for (UInt c=0; c<newValues.size(); c++) {
+			if (!hCols->Item(c+1)->SetValues(newValues[c])) {
+				for (UInt j=0; j<c; j++) hCols->Item(j+1)->SetValues(oldValues[j]);
+				if (recBsd) hTable->SetRecordBased(true);
+				return false;
+			}
+		}
+		return !recBsd || hTable->SetRecordBased(true);
+	}
+
+	// {internal}
+	// Description:
+	// Gathers the elements of a vector with the specified (1-based)
+	// indexes into a new vector of the same data type. If missing is
+	// true, the index 0 yields a missing value.
+	static Bool Gather(const Vector &src, const Int *recIdxs, size_t n, Vector &result, Bool missing = false) {
+		for (size_t i=0; i<n; i++) {
+			if ((recIdxs[i] < 1 && !(missing && recIdxs[i] == 0)) || (size_t)recIdxs[i] > src.Len()) return false;
+		}
+		switch (src.GetDataType()) {
+			case DT_BYTE:   return GatherFixed<Byte>(src, recIdxs, n, result);
+			case DT_INT:    return GatherFixed<Int>(src, recIdxs, n, result);
+			case DT_DOUBLE: return GatherFixed<Double>(src, recIdxs, n, result);
+			case DT_STRING: return GatherComplex<String, DT_STRING>(src, recIdxs, n, result);
+			case DT_VALUE:  return GatherComplex<Value, DT_VALUE>(src, recIdxs, n, result);
+			default:        return n == 0;
+		}
+	}
+
+	template<class T> static Bool GatherFixed(const Vector &src, const Int *recIdxs, size_t n, Vector &result) {
+		const T *pSrc = ColumnData::GetPtr<T>(src);
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, n);
+		if (!p && n) return false;
+		for (size_t i=0; i<n; i++) p[i] = recIdxs[i] ? pSrc[recIdxs[i] - 1] : ColumnType<T>::GetMissing();
+		result = v;
+		return true;
+	}
+
+	template<class T, DataType dt> static Bool GatherComplex(const Vector &src, const Int *recIdxs, size_t n, Vector &result) {
+		CTypedVector<T, dt> s(src), v;
+		if (!v.ReDim(n)) return false;
+		if (n) {
+			const T *pSrc = s.GetPtr();
+			T *p = &v[0];
+			for (size_t i=0; i<n; i++) {
+				if (recIdxs[i]) p[i] = pSrc[recIdxs[i] - 1];
+			}
+		}
+		result = v;
+		return true;
+	}
+
+	// {internal}
+	// Description:
+	// Concatenates the first headLen elements of a vector and another
+	// vector of the same data type.
+	static Bool Concat(const Vector &head, size_t headLen, const Vector &tail, Vector &result) {
+		DataType dt = tail.Len() ? tail.GetDataType() : head.GetDataType();
+		switch (dt) {
+			case DT_BYTE:   return ConcatFixed<Byte>(head, headLen, tail, result);
+			case DT_INT:    return ConcatFixed<Int>(head, headLen, tail, result);
+			case DT_DOUBLE: return ConcatFixed<Double>(head, headLen, tail, result);
+			case DT_STRING: return ConcatComplex<String, DT_STRING>(head, headLen, tail, result);
+			case DT_VALUE:  return ConcatComplex<Value, DT_VALUE>(head, headLen, tail, result);
+			default:        return tail.Len() == 0;
+		}
+	}
+
+	template<class T> static Bool ConcatFixed(const Vector &head, size_t headLen, const Vector &tail, Vector &result) {
+		size_t n = headLen, m = tail.Len();
+		const T *pHead = ColumnData::GetPtr<T>(head), *pTail = ColumnData::GetPtr<T>(tail);
+		if ((n && !pHead) || (m && !pTail)) return false;
+		typename ColumnType<T>::VectorType v;
+		T *p = ColumnData::Alloc<T>(v, n + m);
+		if (!p) return n + m == 0;
+		if (n) memcpy(p,     pHead, n * sizeof(T));
+		if (m) memcpy(p + n, pTail, m * sizeof(T));
+		result = v;
+		return true;
+	}
+
+	template<class T, DataType dt> static Bool ConcatComplex(const Vector &head, size_t headLen, const Vector &tail, Vector &result) {
+		size_t n = headLen, m = tail.Len();
+		CTypedVector<T, dt> h(head), t(tail), v;
+		if (!v.ReDim(n + m)) return false;
+		if (n + m) {
+			T *p = &v[0];
+			for (size_t i=0; i<n; i++) p[i]     = h.GetPtr()[i];
+			for (size_t i=0; i<m; i++) p[n + i] = t.GetPtr()[i];
+		}
+		result = v;
+		return true;
+	}
+
+	template<class T> static Bool FromDoubles(const Double *pSrc, size_t Len, Vector &v) {
+		T *pDst = (T *)AllocColumn<T>(v, Len);
+		return (pDst || !Len) && FromDoubles(pSrc, 1, pDst, 0, Len);
+	}
+
+	// {internal}
+	// Description:
+	// Raw data pointer and storage data type of a numeric column.
+	// The pointers are resolved before work is handed to other threads,
+	// so no (non thread-safe) vector reference counting happens there.
+	struct DenseColumn {
+		DataType Type;
+		void    *Ptr;
+	};
+
+	template<class T> static void *AllocColumn(Vector &v, size_t Len) {
+		typename ColumnType<T>::VectorType tv;
+		T *p = ColumnData::Alloc<T>(tv, Len);
+		v = tv;
+		return p;
+	}
+
+	static Bool GetDenseColumns(ITableHandle &hTable, std::vector<Vector> &values, std::vector<DenseColumn> &columns, UInt &noRecs) {
+		if (!hTable->GetRecordBased()) {
+			Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "The table must be record-based.");
+			return false;
+		}
+		IVariablesHandle hCols = hTable->GetColumns();
+		UInt noCols = hCols->GetCount();
+		values.resize(noCols);
+		columns.resize(noCols);
+		noRecs = noCols ? hCols->Item(1)->GetLength() : 0;
+		for (UInt c=0; c<noCols; c++) {
+			values[c] = hCols->Item(c+1)->GetValues();
+			columns[c].Type = values[c].GetDataType();
+			switch (columns[c].Type) {
+				case DT_BYTE:   columns[c].Ptr = (void *)ColumnData::GetPtr<Byte>(values[c]);   break;
+				case DT_INT:    columns[c].Ptr = (void *)ColumnData::GetPtr<Int>(values[c]);    break;
+				case DT_DOUBLE: columns[c].Ptr = (void *)ColumnData::GetPtr<Double>(values[c]); break;
+				default:
+					if (!noRecs) { columns[c].Type = DT_DOUBLE; columns[c].Ptr = 0; break; }
+					Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "All columns must have a numeric data type.");
+					return false;
+			}
+			if (values[c].Len() != noRecs) {
+				Error::SetError(IUnknownHandle(hTable.GetPtr()), EN_BADARG, "All columns must have the same length.");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// number of records per transposition tile, so that a tile of all
+	// columns (about 256 KB) stays in the cache while the columns are visited
+	static size_t GetTileRecordCount(size_t noCols) {
+		size_t n = noCols ? (256 * 1024 / sizeof(Double)) / noCols : 0;
+		return n < 16 ? 16 : n;
+	}
+
+	// writes validated dense columns to a matrix (see ExportToDenseMatrix)
+	static void ExportColumns(const std::vector<DenseColumn> &columns, UInt noRecs, Double *matrix, Bool rowMajor) {
+		size_t noCols = columns.size();
+		if (!rowMajor) {
+			Parallel::For(0, noCols, 1, [&](size_t c0, size_t c1) {
+				for (size_t c=c0; c<c1; c++) ToDoubles(columns[c], 0, noRecs, matrix + c * noRecs, 1);
+			});
+			return;
+		}
+		size_t tileRecs = GetTileRecordCount(noCols);
+		Parallel::For(0, noRecs, tileRecs, [&](size_t r0, size_t r1) {
+			for (size_t rt=r0; rt<r1; rt+=tileRecs) {
+				size_t re = (r1 - rt < tileRecs) ? r1 : rt + tileRecs;
+				for (size_t c=0; c<noCols; c++) ToDoubles(columns[c], rt, re, matrix + rt * noCols + c, noCols);
+			}
+		});
+	}
+
+	static void ToDoubles(const DenseColumn &column, size_t first, size_t last, Double *pDst, size_t stride) {
+		switch (column.Type) {
+			case DT_BYTE:   ToDoubles((const Byte *)column.Ptr, first, last, pDst, stride);   break;
+			case DT_INT:    ToDoubles((const Int *)column.Ptr, first, last, pDst, stride);    break;
+			case DT_DOUBLE: ToDoubles((const Double *)column.Ptr, first, last, pDst, stride); break;
+			default:        break;
+		}
+	}
+	template<class T> static void ToDoubles(const T *pSrc, size_t first, size_t last, Double *pDst, size_t stride) {
+		for (size_t r=first; r<last; r++, pDst+=stride) *pDst = ColumnData::ToDouble(pSrc[r]);
+	}
+
+	// converts doubles to the values of a column; returns false if a value
+	// cannot be converted (it is stored as missing value then)
+	static Bool FromDoubles(const Double *pSrc, size_t stride, DenseColumn &column, size_t first, size_t last) {
+		switch (column.Type) {
+			case DT_BYTE:   return FromDoubles(pSrc, stride, (Byte *)column.Ptr, first, last);
+			case DT_INT:    return FromDoubles(pSrc, stride, (Int *)column.Ptr, first, last);
+			case DT_DOUBLE: return FromDoubles(pSrc, stride, (Double *)column.Ptr, first, last);
+			default:        return false;
+		}
+	}
+	template<class T> static Bool FromDoubles(const Double *pSrc, size_t stride, T *pDst, size_t first, size_t last) {
+		Bool isValid = true;
+		for (size_t r=first; r<last; r++, pSrc+=stride) {
+			if (!ColumnData::IsMissing(*pSrc) && IsInRange(*pSrc, pDst)) {
+				pDst[r] = (T)*pSrc;
+				continue;
+			}
+			if (!ColumnData::IsMissing(*pSrc)) isValid = false;
+			pDst[r] = ColumnType<T>::GetMissing();
+		}
+		return isValid;
+	}
+	static Bool FromDoubles(const Double *pSrc, size_t stride, Double *pDst, size_t first, size_t last) {
+		for (size_t r=first; r<last; r++, pSrc+=stride) pDst[r] = *pSrc;
+		return true;
+	}
+
+	// tests if a (non-NaN) double is integral and within the range of
+	// byte or integer values, so that the conversion is exact; the
+	// integer bounds are INT_MIN and INT_MAX of DCI.h
+	static Bool IsInRange(Double d, const Byte *) { return d >= BYTE_MIN && d <= BYTE_MAX && d == floor(d); }
+	static Bool IsInRange(Double d, const Int *)  { return d >= (Int)0x80000010 && d <= (Int)0x7ffffff0 && d == floor(d); }
+
+	// {internal}
+	// Description:
+	// Sort key of a record and its (zero-based) index, sorted by the
+	// radix sort.
+	struct SortItem {
+		unsigned long long Key;
+		UInt               Index;
+	};
+
+	// Sort keys are unsigned integers ordered like the values; missing
+	// values are mapped to a key greater than the key of any value, and
+	// descending order inverts the keys of the values.
+	static unsigned long long GetSortKey(Byte b, Bool asc) {
+		if (ColumnData::IsMissing(b)) return 0x100ULL;
+		unsigned long long k = (unsigned long long)((Int)(signed char)b + 0x80);
+		return asc ? k : 0xFFULL - k;
+	}
+	static unsigned long long GetSortKey(Int i, Bool asc) {
+		if (ColumnData::IsMissing(i)) return 0x100000000ULL;
+		unsigned long long k = (unsigned long long)((long long)i + 0x80000000LL);
+		return asc ? k : 0xFFFFFFFFULL - k;
+	}
+	static unsigned long long GetSortKey(Double d, Bool asc) {
+		if (d != d) return ~0ULL;
+		if (d == 0.0) d = 0.0; // -0.0 and 0.0 are equal
+		unsigned long long k;
+		memcpy(&k, &d, sizeof(k));
+		k = (k & 0x8000000000000000ULL) ? ~k : (k | 0x8000000000000000ULL);
+		return asc ? k : ~k;
+	}
+
+	// stable LSD radix sort of perm by the values p[perm[i]], using keys of noBytes bytes
+	template<class T> static void RadixSort(const T *p, Bool asc, size_t noBytes, std::vector<UInt> &perm) {
+		size_t n = perm.size();
+		std::vector<SortItem> items(n), tmp(n);
+		std::vector<size_t> counts(noBytes * 256, 0);
+		for (size_t i=0; i<n; i++) {
+			items[i].Key   = GetSortKey(p[perm[i]], asc);
+			items[i].Index = perm[i];
+			for (size_t d=0; d<noBytes; d++) counts[d * 256 + ((items[i].Key >> (8 * d)) & 0xFF)]++;
+		}
+		for (size_t d=0; d<noBytes; d++) {
+			size_t *c = &counts[d * 256];
+			if (c[(items[0].Key >> (8 * d)) & 0xFF] == n) continue; // all keys share this digit
+			for (size_t b=0, offset=0; b<256; b++) {
+				size_t count = c[b];
+				c[b] = offset;
+				offset += count;
+			}
+			for (size_t i=0; i<n; i++) tmp[c[(items[i].Key >> (8 * d)) & 0xFF]++] = items[i];
+			items.swap(tmp);
+		}
+		for (size_t i=0; i<n; i++) perm[i] = items[i].Index;
+	}
+
+	static void SortStrings(const StringVector &sv, Bool asc, std::vector<UInt> &perm) {
+		const String *p = sv.GetPtr();
+		if (asc) {
+			std::stable_sort(perm.begin(), perm.end(), [p](UInt a, UInt b) { return p[a] < p[b]; });
+		} else {
+			std::stable_sort(perm.begin(), perm.end(), [p](UInt a, UInt b) { return p[b] < p[a]; });
+		}
+	}
+
+	static void Permute(const DenseColumn &src, DenseColumn &dst, const UInt *perm, size_t n) {
+		switch (src.Ptr ? src.Type : DT_VOID) {
+			case DT_BYTE:   Permute((const Byte *)src.Ptr, (Byte *)dst.Ptr, perm, n);     break;
+			case DT_INT:    Permute((const Int *)src.Ptr, (Int *)dst.Ptr, perm, n);       break;
+			case DT_DOUBLE: Permute((const Double *)src.Ptr, (Double *)dst.Ptr, perm, n); break;
+			default:        break;
+		}
+	}
+	template<class T> static void Permute(const T *pSrc, T *pDst, const UInt *perm, size_t n) {
+		for (size_t i=0; i<n; i++) pDst[i] = pSrc[perm[i]];
+	}
+
+	enum { JoinGrainSize = 64 * 1024 }; // minimum number of probe records per thread
+
+	static size_t GetRecordCount(ITableHandle &hTable) {
+		IVariablesHandle hCols = hTable->GetColumns();
+		return hCols->GetCount() ? hCols->Item(1)->GetLength() : 0;
+	}
+
+	static Bool HasMissingKey(const std::vector<KeyTable::Column> &columns, size_t i) {
+		for (size_t k=0; k<columns.size(); k++) {
+			if (KeyTable::IsMissing(columns[k], i)) return true;
+		}
+		return false;
+	}
+
+	static const long long *GetKey(const std::vector<KeyTable::Column> &columns, size_t i, std::vector<long long> &key) {
+		KeyTable::GetKey(columns, i, &key[0]);
+		return &key[0];
+	}
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_TABLEOPERATIONS_H_INCLUDED */
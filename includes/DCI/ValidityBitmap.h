@@ -0,0 +1,346 @@
+#ifndef DCI_VALIDITYBITMAP_H_INCLUDED
+#define DCI_VALIDITYBITMAP_H_INCLUDED
+
+#include "DCI/DCI.h"
+#include "DCI/ITable.h"
+#include "DCI/BinaryBuffer.h"
+#include "DCI/ColumnData.h"
+
+#include <stdio.h>
+#include <vector>
+
+namespace DCI {
+
+// {group:Data Classes}
+// Description: Validity Bitmap Class.
+//
+// A validity bitmap records which elements of a column hold a value and
+// which are missing, one bit per element (set for a valid element),
+// packed into 64-bit words. It is kept alongside a column's value
+// vector and lets kernels work on whole words instead of comparing
+// every element against the missing value sentinels (BYTE_NAN, INT_NAN
+// and NaN): counting missing values takes a population count per word,
+// ForEachValid skips words without valid elements, and bitmaps of
+// several columns are combined word by word.
+//
+// A bitmap built from a vector marks the sentinels as missing. Once
+// built, the bitmap is authoritative: an element whose bit is set is
+// valid even if it equals a sentinel, so the full range of integers
+// can be used. FillMissing writes the sentinels back before handing a
+// vector to code that expects them. Elements are indexed from 0, as
+// with Vector.
+//
+// Example:
+//   DoubleVector v = hTable->GetColumn("Concentration")->GetValues();
+//   ValidityBitmap valid(v);
+//   Double sum = valid.Sum(v);
+//   size_t noMissing = valid.GetMissingCount();
+class ValidityBitmap {
+public:
+	// Description:
+	// Constructs a validity bitmap.
+	//
+	// Arguments:
+	// Len   - The number of elements.
+	// valid - true if all elements are valid, false if all are missing.
+	// v     - The vector whose sentinels mark the missing elements.
+	// fp    - The file pointer of a file storing a validity bitmap (see
+	//         SaveToBinaryFile).
+	ValidityBitmap() : m_Len(0) {}
+	ValidityBitmap(size_t Len, Bool valid = true) : m_Len(0) {
+		ReDim(Len, valid);
+	}
+	ValidityBitmap(const Vector &v) : m_Len(0) {
+		Assign(v);
+	}
+	ValidityBitmap(FILE *fp) : m_Len(0) {
+		LoadFromBinaryFile(fp);
+	}
+
+	// Description:
+	// Builds the bitmap of a vector or of the values of a column,
+	// marking the elements equal to the missing value sentinel as
+	// missing. Elements of other data types than byte, integer and
+	// double are all valid.
+	void Assign(const Vector &v) {
+		switch (v.Len() ? v.GetDataType() : DT_VOID) {
+			case DT_BYTE:   AssignTyped(ColumnData::GetPtr<Byte>(v), v.Len()); break;
+			case DT_INT:    AssignTyped(ColumnData::GetPtr<Int>(v), v.Len()); break;
+			case DT_DOUBLE: AssignTyped(ColumnData::GetPtr<Double>(v), v.Len()); break;
+			default:        ReDim(v.Len(), true); break;
+		}
+	}
+	void Assign(const IVariableHandle &hVariable) {
+		Assign(hVariable->GetValues());
+	}
+
+	// Description:
+	// Changes the number of elements. Added elements are valid or
+	// missing as specified.
+	void ReDim(size_t Len, Bool valid = true) {
+		size_t oldLen = m_Len;
+		m_Words.resize(GetWordCount(Len), 0);
+		m_Len = Len;
+		if (Len > oldLen) SetRange(oldLen, Len, valid);
+		ClearTail();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of elements.
+	size_t Len() const {
+		return m_Len;
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns the number of 64-bit words.
+	size_t GetWordCount() const {
+		return m_Words.size();
+	}
+
+	// {group:Read-Only Properties}
+	// Description:
+	// Returns a 64-bit word of the bitmap. Bit j of word w is the
+	// validity of the element with index 64 * w + j.
+	unsigned long long GetWord(size_t w) const {
+		return m_Words[w];
+	}
+
+	// Description:
+	// Tests if an element is valid.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	Bool IsValid(size_t Index) const {
+		return Index < m_Len && (m_Words[Index >> 6] >> (Index & 63) & 1) != 0;
+	}
+
+	// Description:
+	// Marks an element as valid or missing.
+	//
+	// Arguments:
+	// Index - Index of the element (0-based).
+	// valid - true if the element is valid, false if it is missing.
+	void SetValid(size_t Index, Bool valid = true) {
+		if (Index >= m_Len) return;
+		unsigned long long bit = 1ULL << (Index & 63);
+		if (valid) m_Words[Index >> 6] |= bit;
+		else m_Words[Index >> 6] &= ~bit;
+	}
+
+	// Description:
+	// Marks a range of elements as valid or missing.
+	//
+	// Arguments:
+	// first - Index of the first element (0-based).
+	// last  - Index following the last element.
+	// valid - true if the elements are valid, false if they are missing.
+	void SetRange(size_t first, size_t last, Bool valid = true) {
+		if (last > m_Len) last = m_Len;
+		for (; first < last && (first & 63); first++) SetValid(first, valid);
+		for (; first + 64 <= last; first += 64) m_Words[first >> 6] = valid ? ~0ULL : 0ULL;
+		for (; first < last; first++) SetValid(first, valid);
+	}
+
+	// Description:
+	// Returns the number of valid elements.
+	size_t GetValidCount() const {
+		size_t n = 0;
+		for (size_t w=0; w<m_Words.size(); w++) n += PopCount(m_Words[w]);
+		return n;
+	}
+
+	// Description:
+	// Returns the number of missing elements.
+	size_t GetMissingCount() const {
+		return m_Len - GetValidCount();
+	}
+
+	// Description:
+	// Combines the bitmap with the bitmap of another column of equal
+	// length: an element stays valid only if it is valid in both
+	// (&=), or becomes valid if it is valid in either (|=).
+	ValidityBitmap &operator &= (const ValidityBitmap &b) {
+		for (size_t w=0; w<m_Words.size(); w++) m_Words[w] &= w < b.m_Words.size() ? b.m_Words[w] : 0ULL;
+		return *this;
+	}
+	ValidityBitmap &operator |= (const ValidityBitmap &b) {
+		for (size_t w=0; w<m_Words.size() && w<b.m_Words.size(); w++) m_Words[w] |= b.m_Words[w];
+		ClearTail();
+		return *this;
+	}
+
+	// Description:
+	// Calls a function for the index of every valid element, in
+	// ascending order. Words without valid elements are skipped as a
+	// whole.
+	//
+	// Arguments:
+	// f - The function, called as f(size_t Index).
+	template<class F> void ForEachValid(F f) const {
+		for (size_t w=0; w<m_Words.size(); w++) {
+			unsigned long long word = m_Words[w];
+			if (word == ~0ULL) {
+				for (size_t i=w<<6, last=i+64; i<last; i++) f(i);
+				continue;
+			}
+			while (word) {
+				unsigned long long low = word & (0 - word);
+				f((w << 6) + PopCount(low - 1));
+				word ^= low;
+			}
+		}
+	}
+
+	// Description:
+	// Returns the sum or the arithmetic mean of the valid elements of a
+	// byte, integer or double vector.
+	//
+	// Arguments:
+	// v - The vector the bitmap belongs to. It must have the length of
+	//     the bitmap.
+	//
+	// Returns:
+	// The sum (0 if there are no valid elements) or the mean (NaN if
+	// there are no valid elements), or NaN if the lengths differ.
+	Double Sum(const Vector &v) const {
+		if (v.Len() != m_Len) return ColumnType<Double>::GetMissing();
+		switch (v.Len() ? v.GetDataType() : DT_VOID) {
+			case DT_BYTE:   return SumTyped(ColumnData::GetPtr<Byte>(v), v.Len());
+			case DT_INT:    return SumTyped(ColumnData::GetPtr<Int>(v), v.Len());
+			case DT_DOUBLE: return SumTyped(ColumnData::GetPtr<Double>(v), v.Len());
+			default:        return 0.0;
+		}
+	}
+	Double Mean(const Vector &v) const {
+		size_t n = GetValidCount();
+		return n && v.Len() == m_Len ? Sum(v) / n : ColumnType<Double>::GetMissing();
+	}
+
+	// Description:
+	// Writes the missing value sentinel into the missing elements of a
+	// byte, integer or double vector.
+	//
+	// Arguments:
+	// v - The vector the bitmap belongs to. If its length differs from
+	//     the length of the bitmap, it is left unchanged.
+	void FillMissing(Vector &v) const {
+		if (v.Len() != m_Len) return;
+		switch (v.Len() ? v.GetDataType() : DT_VOID) {
+			case DT_BYTE:   FillMissingTyped<Byte>(v); break;
+			case DT_INT:    FillMissingTyped<Int>(v); break;
+			case DT_DOUBLE: FillMissingTyped<Double>(v); break;
+			default:        break;
+		}
+	}
+
+	// Description:
+	// Saves the validity bitmap to a binary file.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool SaveToBinaryFile(FILE *fp) const {
+		unsigned long long len = m_Len;
+		return fwrite(&len, sizeof(len), 1, fp) == 1 &&
+			(m_Words.empty() || fwrite(&m_Words[0], sizeof(unsigned long long), m_Words.size(), fp) == m_Words.size());
+	}
+
+	// Description:
+	// Loads a validity bitmap from a binary file written by
+	// SaveToBinaryFile.
+	//
+	// Arguments:
+	// fp - The file pointer of the file.
+	//
+	// Returns:
+	// true, if the operation succeeded, false otherwise.
+	Bool LoadFromBinaryFile(FILE *fp) {
+		unsigned long long len;
+		ReDim(0);
+		if (fread(&len, sizeof(len), 1, fp) != 1) return false;
+		// check the length before allocating, as it may be corrupt
+		if (len > (size_t)-1 || len / 64 + (len % 64 != 0) > BinaryReader::GetRemaining(fp) / sizeof(unsigned long long)) return false;
+		m_Words.resize(GetWordCount((size_t)len));
+		if (!m_Words.empty() && fread(&m_Words[0], sizeof(unsigned long long), m_Words.size(), fp) != m_Words.size()) {
+			m_Words.clear();
+			return false;
+		}
+		m_Len = (size_t)len;
+		ClearTail();
+		return true;
+	}
+
+private:
+	static size_t GetWordCount(size_t Len) {
+		return (Len + 63) >> 6;
+	}
+
+	// number of set bits (SWAR)
+	static size_t PopCount(unsigned long long x) {
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		return (size_t)((x * 0x0101010101010101ULL) >> 56);
+	}
+
+	// returns the bits of word w belonging to elements with an index below Len
+	static unsigned long long GetMask(size_t w, size_t Len) {
+		size_t first = w << 6;
+		return Len - first >= 64 ? ~0ULL : (1ULL << (Len - first)) - 1;
+	}
+
+	// clears the bits beyond the last element, so that whole words can be counted
+	void ClearTail() {
+		if (m_Len & 63) m_Words.back() &= (1ULL << (m_Len & 63)) - 1;
+	}
+
+	template<class T> void AssignTyped(const T *p, size_t Len) {
+		m_Len = Len;
+		m_Words.assign(GetWordCount(Len), 0);
+		for (size_t w=0; w<m_Words.size(); w++) {
+			size_t first = w << 6, n = Len - first < 64 ? Len - first : 64;
+			unsigned long long word = 0;
+			for (size_t j=0; j<n; j++) word |= (unsigned long long)!ColumnData::IsMissing(p[first+j]) << j;
+			m_Words[w] = word;
+		}
+	}
+
+	template<class T> Double SumTyped(const T *p, size_t Len) const {
+		Double sum = 0.0;
+		for (size_t w=0; w<GetWordCount(Len); w++) {
+			unsigned long long word = m_Words[w] & GetMask(w, Len);
+			if (!word) continue;
+			const T *pWord = p + (w << 6);
+			if (word == ~0ULL) {
+				for (size_t j=0; j<64; j++) sum += pWord[j];
+				continue;
+			}
+			for (; word; word &= word - 1) sum += pWord[PopCount((word & (0 - word)) - 1)];
+		}
+		return sum;
+	}
+
+	template<class T> void FillMissingTyped(Vector &v) const {
+		typename ColumnType<T>::VectorType tv(v);
+		size_t Len = m_Len;
+		T *p = 0;
+		for (size_t w=0; w<GetWordCount(Len); w++) {
+			unsigned long long word = ~m_Words[w] & GetMask(w, Len);
+			if (!word) continue;
+			if (!p) p = &tv[0];
+			for (; word; word &= word - 1) p[(w << 6) + PopCount((word & (0 - word)) - 1)] = ColumnType<T>::GetMissing();
+		}
+		if (p) v = tv;
+	}
+
+	size_t                          m_Len;   // number of elements
+	std::vector<unsigned long long> m_Words; // one bit per element, set if valid
+};
+
+} /* namespace DCI */
+
+#endif /* DCI_VALIDITYBITMAP_H_INCLUDED */